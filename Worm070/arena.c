@@ -0,0 +1,58 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// A per-level memory arena
+
+#include <stdlib.h>
+#include <string.h>
+#include "worm.h"
+#include "arena.h"
+
+// Get one block of memory for the arena.
+// The block is zeroed; callers may rely on that.
+enum ResCodes initializeArena(struct arena* aarena, size_t size) {
+  size = getArenaPieceSize(size);
+  aarena->base = aligned_alloc(ARENA_ALIGNMENT, size);
+  if (aarena->base == NULL) {
+    aarena->size = 0;
+    aarena->used = 0;
+    return RES_FAILED;
+  }
+  memset(aarena->base, 0, size);
+  aarena->size = size;
+  aarena->used = 0;
+  return RES_OK;
+}
+
+// Hand out the next piece of the arena.
+// Returns NULL if the arena is exhausted.
+void* allocFromArena(struct arena* aarena, size_t size) {
+  size_t piece_size = getArenaPieceSize(size);
+  void* piece;
+
+  if (piece_size > aarena->size - aarena->used) {
+    return NULL;
+  }
+  piece = aarena->base + aarena->used;
+  aarena->used += piece_size;
+  return piece;
+}
+
+// Release all pieces of the arena at once
+void releaseArena(struct arena* aarena) {
+  free(aarena->base);
+  aarena->base = NULL;
+  aarena->size = 0;
+  aarena->used = 0;
+}
+
+// Round size up to the alignment of the arena
+size_t getArenaPieceSize(size_t size) {
+  return (size + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+}
@@ -0,0 +1,37 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// A per-level memory arena
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stddef.h>
+#include "worm.h"
+
+// Alignment of all pieces handed out by the arena (one cache line)
+#define ARENA_ALIGNMENT 64
+
+// An arena is one contiguous block of memory that is handed out piece by piece.
+// There is no way to return a single piece: all pieces are released together
+// by a single call of releaseArena() at the end of the level.
+struct arena {
+    char* base;   // Start of the block
+    size_t size;  // Size of the block in bytes
+    size_t used;  // Number of bytes handed out so far
+};
+
+extern enum ResCodes initializeArena(struct arena* aarena, size_t size);
+extern void* allocFromArena(struct arena* aarena, size_t size);
+extern void releaseArena(struct arena* aarena);
+
+// Number of bytes a piece of the given size occupies in an arena
+extern size_t getArenaPieceSize(size_t size);
+
+#endif  // #define _ARENA_H
@@ -0,0 +1,528 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Board benchmark
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "worm.h"
+#include "arena.h"
+#include "level.h"
+#include "board_model.h"
+#include "board_planes.h"
+#include "worm_model.h"
+#include "level_check.h"
+#include "swarm.h"
+#include "board_bench.h"
+
+// Keep the compiler from dropping a copy nobody reads
+static inline void keepMemory(void* data) {
+  __asm__ volatile("" : : "r" (data) : "memory");
+}
+
+// Count the free cells and the barriers, reading the cells through the
+// board accessors
+static void scanCells(struct board* aboard, long* afree, long* abarriers) {
+  enum BoardCodes code;
+  long free_cells = 0;
+  long barriers = 0;
+  int y;
+  int x;
+
+  for (y = 0; y <= aboard->last_row; y++) {
+    for (x = 0; x <= aboard->last_col; x++) {
+      code = getContentOfCell(aboard, getCellIndex(aboard, y, x));
+      free_cells += code == BC_FREE_CELL;
+      barriers += code == BC_BARRIER;
+    }
+  }
+  *afree += free_cells;
+  *abarriers += barriers;
+}
+
+// The same on cells stored as enum BoardCodes, indexed like the board
+static void scanWideCells(struct board* aboard, enum BoardCodes* wide,
+                          long* afree, long* abarriers) {
+  enum BoardCodes code;
+  long free_cells = 0;
+  long barriers = 0;
+  int y;
+  int x;
+
+  for (y = 0; y <= aboard->last_row; y++) {
+    for (x = 0; x <= aboard->last_col; x++) {
+      code = wide[getCellIndex(aboard, y, x)];
+      free_cells += code == BC_FREE_CELL;
+      barriers += code == BC_BARRIER;
+    }
+  }
+  *afree += free_cells;
+  *abarriers += barriers;
+}
+
+// Tell how long one pass over all cells took
+static void showTime(const char* name, double seconds, struct board* aboard) {
+  double cells = (double) (aboard->last_row + 1) * (aboard->last_col + 1);
+
+  printf("  %-34s %8.3f ms  %6.2f ns/Zelle\n", name, seconds * 1e3, seconds / cells * 1e9);
+}
+
+// Tell how many bytes per cell of the board a part of the storage takes
+static void showBytes(const char* name, size_t bytes, struct board* aboard) {
+  double cells = (double) (aboard->last_row + 1) * (aboard->last_col + 1);
+
+  printf("  %-34s %8.2f Bytes/Zelle\n", name, bytes / cells);
+}
+
+// What a cell costs in memory: the byte of the cell is only part of it.
+// The bit planes, the set of free cells with its slots and the owner plane
+// of the worm set (one uint16_t per cell, see initializeWorms()) come on top.
+static void showStorage(struct board* aboard) {
+  size_t rows = aboard->last_row + 1;
+  size_t cols = aboard->last_col + 1;
+  size_t stored_cells = getNumberOfStoredCells(aboard);
+  size_t planes = BP_NUMBER_OF_PLANES * getPlaneStorageSize(rows, cols);
+  size_t free_set = getArenaPieceSize(rows * cols * sizeof(int))
+                    + getArenaPieceSize(stored_cells * sizeof(int));
+
+  printf("Speicher des Spielfelds:\n");
+  showBytes("Zellen", stored_cells, aboard);
+  showBytes("Bitebenen", planes, aboard);
+  showBytes("Menge der freien Zellen", free_set, aboard);
+  showBytes("zusammen (siehe Kopie unten)", aboard->storage_size, aboard);
+  showBytes("Besitzer der Zellen (Wuermer)", (rows + 2) * aboard->stride * sizeof(uint16_t), aboard);
+  showBytes("Zellen als enum (frueher)", rows * cols * sizeof(enum BoardCodes), aboard);
+}
+
+// Tell how long a worm step took on average
+static void showStepTime(const char* name, double seconds, long steps) {
+  printf("  %-34s %8.3f ms  %6.2f ns/Schritt\n", name, seconds * 1e3, seconds / steps * 1e9);
+}
+
+// Scans and copies of all cells of the level, as bytes and as enums
+static enum ResCodes measureScans(struct board* aboard) {
+  size_t indexed_cells = (size_t) (aboard->last_row + 3) * aboard->stride;
+  size_t stored_cells = getNumberOfStoredCells(aboard);
+  long free_cells = 0;
+  long barriers = 0;
+  long wide_free_cells = 0;
+  long wide_barriers = 0;
+  long plane_free_cells = 0;
+  enum BoardCodes* wide;
+  enum BoardCodes* wide_copy;
+  uint8_t* copy;
+  double start;
+  double bytes_scan;
+  double wide_scan;
+  double plane_scan;
+  double bytes_copy;
+  double storage_copy;
+  double wide_copy_time;
+  size_t i;
+  int r;
+
+  wide = malloc(indexed_cells * sizeof(enum BoardCodes));
+  wide_copy = malloc(indexed_cells * sizeof(enum BoardCodes));
+  copy = malloc(aboard->storage_size);
+  if (wide == NULL || wide_copy == NULL || copy == NULL) {
+    free(wide);
+    free(wide_copy);
+    free(copy);
+    fprintf(stderr, "Kein Speicher fuer den Vergleich\n");
+    return RES_FAILED;
+  }
+  for (i = 0; i < indexed_cells; i++) {
+    wide[i] = getContentOfCell(aboard, i);
+  }
+
+  start = getBenchmarkSeconds();
+  for (r = 0; r < BENCH_REPEATS; r++) {
+    scanCells(aboard, &free_cells, &barriers);
+  }
+  bytes_scan = (getBenchmarkSeconds() - start) / BENCH_REPEATS;
+  start = getBenchmarkSeconds();
+  for (r = 0; r < BENCH_REPEATS; r++) {
+    scanWideCells(aboard, wide, &wide_free_cells, &wide_barriers);
+  }
+  wide_scan = (getBenchmarkSeconds() - start) / BENCH_REPEATS;
+  // The free cells only, 64 at a time from the bit planes
+  start = getBenchmarkSeconds();
+  for (r = 0; r < BENCH_REPEATS; r++) {
+    plane_free_cells += countFreeCells(aboard);
+  }
+  plane_scan = (getBenchmarkSeconds() - start) / BENCH_REPEATS;
+
+  // Snapshots of the board: a copy of all stored cells
+  start = getBenchmarkSeconds();
+  for (r = 0; r < BENCH_REPEATS; r++) {
+    memcpy(copy, aboard->cells, stored_cells);
+    keepMemory(copy);
+  }
+  bytes_copy = (getBenchmarkSeconds() - start) / BENCH_REPEATS;
+  // A snapshot the board can go on with needs the whole storage block
+  start = getBenchmarkSeconds();
+  for (r = 0; r < BENCH_REPEATS; r++) {
+    memcpy(copy, aboard->storage, aboard->storage_size);
+    keepMemory(copy);
+  }
+  storage_copy = (getBenchmarkSeconds() - start) / BENCH_REPEATS;
+  start = getBenchmarkSeconds();
+  for (r = 0; r < BENCH_REPEATS; r++) {
+    memcpy(wide_copy, wide, indexed_cells * sizeof(enum BoardCodes));
+    keepMemory(wide_copy);
+  }
+  wide_copy_time = (getBenchmarkSeconds() - start) / BENCH_REPEATS;
+
+  printf("Durchlauf ueber alle Zellen (%ld frei, %ld Mauer):\n",
+      free_cells / BENCH_REPEATS, barriers / BENCH_REPEATS);
+  showTime("Zellen als Bytes", bytes_scan, aboard);
+  showTime("Zellen als enum (4 Bytes)", wide_scan, aboard);
+  showTime("Bitebenen (nur freie Zellen)", plane_scan, aboard);
+  printf("Kopie aller Zellen (%zu Zellen mit Rand):\n", stored_cells);
+  showTime("Zellen als Bytes", bytes_copy, aboard);
+  showTime("ganzer Speicher des Spielfelds", storage_copy, aboard);
+  showTime("Zellen als enum (4 Bytes)", wide_copy_time, aboard);
+
+  free(wide);
+  free(wide_copy);
+  free(copy);
+  if (free_cells != wide_free_cells || barriers != wide_barriers
+      || free_cells != plane_free_cells) {
+    fprintf(stderr, "Fehler: die Durchlaeufe zaehlen verschieden\n");
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
+
+// Is the cell with the given index open to a worm?
+static inline bool isOpenCell(struct board* aboard, int index) {
+  enum BoardCodes code = getContentOfCell(aboard, index);
+  return code != BC_BARRIER && code != BC_OUT_OF_BOUNDS;
+}
+
+// Breadth-first flood fill over the cells from the start position with
+// four neighbours per cell. The marks of the visited cells are stored
+// like the cells (see getCellOffset()), so they follow the layout, too.
+// Returns the number of cells reached.
+static long floodCells(struct board* aboard, int* queue, uint8_t* seen) {
+  int deltas[4];
+  struct pos start = getStartPosition(aboard);
+  long head = 0;
+  long tail = 0;
+  int index;
+  int next;
+  int k;
+
+  deltas[0] = getIndexDelta(aboard, -1, 0);
+  deltas[1] = getIndexDelta(aboard, 1, 0);
+  deltas[2] = getIndexDelta(aboard, 0, -1);
+  deltas[3] = getIndexDelta(aboard, 0, 1);
+  index = getCellIndex(aboard, start.y, start.x);
+  seen[getCellOffset(aboard, index)] = 1;
+  queue[tail++] = index;
+  while (head < tail) {
+    index = queue[head++];
+    for (k = 0; k < 4; k++) {
+      next = index + deltas[k];
+      if (!seen[getCellOffset(aboard, next)] && isOpenCell(aboard, next)) {
+        seen[getCellOffset(aboard, next)] = 1;
+        queue[tail++] = next;
+      }
+    }
+  }
+  return tail;
+}
+
+// Count the barriers among the eight neighbours of every cell
+static long scanNeighbourhoods(struct board* aboard) {
+  int deltas[8];
+  long barriers = 0;
+  int index;
+  int y;
+  int x;
+  int k = 0;
+  int dy;
+  int dx;
+
+  for (dy = -1; dy <= 1; dy++) {
+    for (dx = -1; dx <= 1; dx++) {
+      if (dy != 0 || dx != 0) {
+        deltas[k++] = getIndexDelta(aboard, dy, dx);
+      }
+    }
+  }
+  for (y = 0; y <= aboard->last_row; y++) {
+    for (x = 0; x <= aboard->last_col; x++) {
+      index = getCellIndex(aboard, y, x);
+      for (k = 0; k < 8; k++) {
+        barriers += getContentOfCell(aboard, index + deltas[k]) == BC_BARRIER;
+      }
+    }
+  }
+  return barriers;
+}
+
+// Flood fills and neighbourhood scans: the accesses that go up and down
+// as often as left and right, where the layout of the cells matters.
+// The flood fill on the bit planes (see checkLevel()) does not depend on
+// the layout; it is shown for comparison.
+static enum ResCodes measureNeighbours(struct board* aboard) {
+  size_t stored_cells = getNumberOfStoredCells(aboard);
+  struct level_check check;
+  int* queue;
+  uint8_t* seen;
+  double start;
+  double fill;
+  double plane_fill;
+  double neighbourhoods;
+  long reached;
+  long barriers;
+
+  queue = malloc((size_t) (aboard->last_row + 1) * (aboard->last_col + 1) * sizeof(int));
+  seen = calloc(stored_cells, sizeof(uint8_t));
+  if (queue == NULL || seen == NULL) {
+    free(queue);
+    free(seen);
+    fprintf(stderr, "Kein Speicher fuer die Fuellung\n");
+    return RES_FAILED;
+  }
+  start = getBenchmarkSeconds();
+  reached = floodCells(aboard, queue, seen);
+  fill = getBenchmarkSeconds() - start;
+  free(queue);
+  free(seen);
+
+  start = getBenchmarkSeconds();
+  if (checkLevel(aboard, &check) != RES_OK) {
+    fprintf(stderr, "Kein Speicher fuer die Fuellung\n");
+    return RES_FAILED;
+  }
+  plane_fill = getBenchmarkSeconds() - start;
+  releaseLevelCheck(&check);
+
+  start = getBenchmarkSeconds();
+  barriers = scanNeighbourhoods(aboard);
+  neighbourhoods = getBenchmarkSeconds() - start;
+
+  printf("Fuellung vom Start aus (%ld Zellen erreicht):\n", reached);
+  showTime("Breitensuche ueber die Zellen", fill, aboard);
+  showTime("Bitebenen (checkLevel)", plane_fill, aboard);
+  printf("Nachbarschaft aller Zellen (%ld Mauern gezaehlt):\n", barriers);
+  showTime("8 Nachbarn je Zelle", neighbourhoods, aboard);
+  if (reached != check.reachable_cells) {
+    fprintf(stderr, "Fehler: die Fuellungen erreichen %ld und %d Zellen\n",
+        reached, check.reachable_cells);
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
+
+// The worm as moveWorm() moved it before the cells became bytes:
+// positions in a ring buffer, cells of enum BoardCodes in rows
+struct bench_worm {
+    struct pos* positions;
+    int length;
+    int headindex;
+};
+
+static inline enum BoardCodes getBenchCell(void* cells, int cell_size, size_t i) {
+  return cell_size == 1 ? ((uint8_t*) cells)[i] : ((enum BoardCodes*) cells)[i];
+}
+
+static inline void setBenchCell(void* cells, int cell_size, size_t i, enum BoardCodes code) {
+  if (cell_size == 1) {
+    ((uint8_t*) cells)[i] = code;
+  } else {
+    ((enum BoardCodes*) cells)[i] = code;
+  }
+}
+
+// One step of moveWorm() as it was, on a torus: the tail is cleared, the
+// cell ahead is looked at and the head written. cell_size is 1 for bytes
+// or the size of an enum; the callers pass constants.
+static inline bool stepBenchWorm(struct bench_worm* aworm, void* cells, int cell_size,
+                                 int rows, int cols, int dy, int dx) {
+  struct pos head = aworm->positions[aworm->headindex];
+  int tailindex = aworm->headindex + 1 == aworm->length ? 0 : aworm->headindex + 1;
+  struct pos tail = aworm->positions[tailindex];
+
+  // The worm appears element by element
+  if (tail.y >= 0) {
+    setBenchCell(cells, cell_size, (size_t) tail.y * cols + tail.x, BC_FREE_CELL);
+  }
+  head.y = (head.y + dy + rows) % rows;
+  head.x = (head.x + dx + cols) % cols;
+  switch (getBenchCell(cells, cell_size, (size_t) head.y * cols + head.x)) {
+    case BC_BARRIER:
+    case BC_USED_BY_WORM:
+      return false;
+    default:
+      break;
+  }
+  setBenchCell(cells, cell_size, (size_t) head.y * cols + head.x, BC_USED_BY_WORM);
+  aworm->headindex = tailindex;
+  aworm->positions[tailindex] = head;
+  return true;
+}
+
+// The staircase of measureWormSteps() with the former worm model.
+// Returns the number of steps the worm made or -1 without memory.
+static long runBenchWorm(int rows, int cols, int length, int cell_size, double* aseconds) {
+  struct bench_worm theworm;
+  void* cells = calloc((size_t) rows * cols, cell_size);  // All BC_FREE_CELL
+  double start;
+  long step;
+  int i;
+  bool down;
+
+  theworm.positions = malloc(length * sizeof(struct pos));
+  if (cells == NULL || theworm.positions == NULL) {
+    free(cells);
+    free(theworm.positions);
+    return -1;
+  }
+  theworm.length = length;
+  theworm.headindex = 0;
+  for (i = 0; i < length; i++) {
+    theworm.positions[i].y = -1;
+    theworm.positions[i].x = -1;
+  }
+  theworm.positions[0].y = 0;
+  theworm.positions[0].x = 0;
+  setBenchCell(cells, cell_size, 0, BC_USED_BY_WORM);
+
+  start = getBenchmarkSeconds();
+  for (step = 0; step < BENCH_WORM_STEPS; step++) {
+    down = (step / BENCH_WORM_LEG) % 2;
+    if ((cell_size == 1
+         && !stepBenchWorm(&theworm, cells, 1, rows, cols, down, !down))
+        || (cell_size != 1
+            && !stepBenchWorm(&theworm, cells, sizeof(enum BoardCodes), rows, cols, down, !down))) {
+      break;
+    }
+  }
+  *aseconds = getBenchmarkSeconds() - start;
+  free(cells);
+  free(theworm.positions);
+  return step;
+}
+
+// A worm runs across an empty torus board in a staircase: BENCH_WORM_LEG
+// steps right, the same number down, and so on. The staircase comes back
+// to a cell after at least as many steps as the board has rows or columns;
+// a worm shorter than that never gets in its own way.
+static enum ResCodes measureWormSteps(int rows, int cols) {
+  struct arena thearena;
+  struct board theboard;
+  struct worm_set worms;
+  struct pos start_pos = { 0, 0 };
+  int length = BENCH_WORM_LENGTH;
+  double start;
+  double seconds;
+  double wide_seconds;
+  double bytes_seconds;
+  long wide_steps;
+  long bytes_steps;
+  long step;
+
+  if (length > (rows < cols ? rows : cols) / 2) {
+    length = (rows < cols ? rows : cols) / 2;
+  }
+
+  // The baseline: the former worm on enum cells and on byte cells
+  wide_steps = runBenchWorm(rows, cols, length, sizeof(enum BoardCodes), &wide_seconds);
+  bytes_steps = runBenchWorm(rows, cols, length, 1, &bytes_seconds);
+  if (wide_steps < 0 || bytes_steps < 0) {
+    fprintf(stderr, "Kein Speicher fuer den Wurm\n");
+    return RES_FAILED;
+  }
+
+  if (initializeArena(&thearena, getBoardStorageSize(rows, cols)) != RES_OK) {
+    fprintf(stderr, "Kein Speicher fuer das Spielfeld\n");
+    return RES_FAILED;
+  }
+  if (initializeBoard(&theboard, &thearena, rows, cols) != RES_OK) {
+    fprintf(stderr, "Spielfeld mit %dx%d Zellen nicht moeglich\n", rows, cols);
+    releaseArena(&thearena);
+    return RES_FAILED;
+  }
+  setBoardTorus(&theboard, true);
+  if (initializeWorms(&worms, &theboard, 1) != RES_OK) {
+    fprintf(stderr, "Kein Speicher fuer den Wurm\n");
+    releaseArena(&thearena);
+    return RES_FAILED;
+  }
+  if (addWorm(&worms, &theboard, length, start_pos, WORM_RIGHT,
+              COLP_USER_WORM, false) != USER_WORM) {
+    fprintf(stderr, "Kein Speicher fuer den Wurm\n");
+    releaseWorms(&worms);
+    releaseArena(&thearena);
+    return RES_FAILED;
+  }
+
+  start = getBenchmarkSeconds();
+  for (step = 0; step < BENCH_WORM_STEPS && getWormState(&worms, USER_WORM) == WORM_GAME_ONGOING; step++) {
+    if (step % BENCH_WORM_LEG == 0) {
+      setWormHeading(&worms, USER_WORM, (step / BENCH_WORM_LEG) % 2 ? WORM_DOWN : WORM_RIGHT);
+    }
+    stepWorms(&worms, &theboard);
+  }
+  seconds = getBenchmarkSeconds() - start;
+
+  printf("Wurm mit %d Elementen auf leerem Torus:\n", length);
+  showStepTime("moveWorm() wie frueher, enum", wide_seconds, wide_steps);
+  showStepTime("moveWorm() wie frueher, Bytes", bytes_seconds, bytes_steps);
+  showStepTime("stepWorms()", seconds, step);
+  releaseWorms(&worms);
+  releaseArena(&thearena);
+  if (step < BENCH_WORM_STEPS || wide_steps < BENCH_WORM_STEPS || bytes_steps < BENCH_WORM_STEPS) {
+    fprintf(stderr, "Fehler: ein Wurm ist vorzeitig gestorben\n");
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
+
+// Run all measurements on a level generated from the seed of the settings.
+// Runs without curses; messages go to stdout and stderr.
+enum ResCodes runBoardBenchmark(struct game_settings* asettings) {
+  struct level thelevel;
+  enum ResCodes res_code;
+
+  if (asettings->rows == 0) {
+    asettings->rows = BENCH_DEFAULT_ROWS;
+  }
+  if (asettings->cols == 0) {
+    asettings->cols = BENCH_DEFAULT_COLS;
+  }
+  asettings->generate = true;
+  if (setupLevel(&thelevel, asettings) != RES_OK) {
+    fprintf(stderr, "%s\n", thelevel.error);
+    return RES_FAILED;
+  }
+#ifdef BOARD_LAYOUT_TILED
+  printf("Spielfeld: %dx%d Zellen, in Kacheln von %dx%d Zellen\n",
+      asettings->rows, asettings->cols, BOARD_TILE_SIZE, BOARD_TILE_SIZE);
+#else
+  printf("Spielfeld: %dx%d Zellen, zeilenweise\n", asettings->rows, asettings->cols);
+#endif
+
+  showStorage(&thelevel.board);
+  res_code = measureScans(&thelevel.board);
+  if (res_code == RES_OK) {
+    res_code = measureNeighbours(&thelevel.board);
+  }
+  releaseLevel(&thelevel);
+  if (res_code == RES_OK) {
+    res_code = measureWormSteps(asettings->rows, asettings->cols);
+  }
+  return res_code;
+}
@@ -0,0 +1,33 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Board benchmark: the basic operations on the cells of a large board,
+// measured without the display.
+//
+// Full-board scans and copies run on the cells (one byte each) and, for
+// comparison, on a copy of them with one enum BoardCodes per cell as the
+// board used to store them. Flood fills and neighbourhood scans show the
+// effect of the layout of the cells (see BOARD_LAYOUT_TILED). A single
+// worm runs across an empty torus board to time stepWorms().
+
+#ifndef _BOARD_BENCH_H
+#define _BOARD_BENCH_H
+
+#include "worm.h"
+
+#define BENCH_DEFAULT_ROWS 4096  // Size of the board unless given by -r and -c
+#define BENCH_DEFAULT_COLS 4096
+#define BENCH_REPEATS 10         // Scans and copies per measurement
+#define BENCH_WORM_LENGTH 1000   // Length of the worm running across the board (at most)
+#define BENCH_WORM_STEPS 5000000 // Steps of that worm
+#define BENCH_WORM_LEG 64        // Steps between two turns of the worm
+
+extern enum ResCodes runBoardBenchmark(struct game_settings* asettings);
+
+#endif  // #define _BOARD_BENCH_H
@@ -10,20 +10,81 @@
   // The board model
 
 #include <curses.h>
+#include <string.h>
 #include "worm.h"
 #include "board_model.h"
-#include "messages.h"
+#include "board_planes.h"
+#include "entity.h"
 
   // *************************************************
   // Placing and removing items from the game board
   // Check boundaries of game board
   // *************************************************
 
-  // Place an item onto the curses display.
-  void placeItem(struct board* aboard, int y, int x, enum BoardCodes board_code, chtype symbol, enum ColorPairs color_pair) {
-    
-    // Store board_code in aboard->cells
-    aboard->cells[y][x] = board_code;
+  // Add the cell with the given index to the set of free cells
+  static void addFreeCell(struct board* aboard, int index) {
+    aboard->free_slot[index] = aboard->free_count;
+    aboard->free_cells[aboard->free_count] = index;
+    aboard->free_count++;
+  }
+
+  // Remove the cell with the given index from the set of free cells.
+  // The last entry of the set takes over its slot.
+  static void removeFreeCell(struct board* aboard, int index) {
+    int slot = aboard->free_slot[index];
+    int last = aboard->free_cells[aboard->free_count - 1];
+
+    aboard->free_cells[slot] = last;
+    aboard->free_slot[last] = slot;
+    aboard->free_slot[index] = -1;
+    aboard->free_count--;
+  }
+
+  // Store an entity in the cell with the given index at position (y,x).
+  // Keeps the bit planes, the food counters and the set of free cells
+  // in line with the cells.
+  static void storeEntity(struct board* aboard, int index, int y, int x, enum EntityTypes type) {
+    uint8_t* cell = getCell(aboard, index);
+    enum BoardCodes old_code = *cell & BC_CODE_MASK;
+    enum EntityTypes old_type = getCellType(*cell);
+    enum BoardCodes board_code = entity_behaviours[type].code;
+    updatePlanes(aboard, y, x, old_code, board_code);
+    *cell = board_code | (type << BC_TYPE_SHIFT);
+    // Keep the food counters in line with the board
+    if (isCountedFood(old_type)) {
+      aboard->food_items--;
+      aboard->food_items_of_type[old_type - ET_FOOD_1]--;
+    }
+    if (isCountedFood(type)) {
+      aboard->food_items++;
+      aboard->food_items_of_type[type - ET_FOOD_1]++;
+    }
+    // Keep the set of free cells in line with the board
+    if (old_code == BC_FREE_CELL && board_code != BC_FREE_CELL) {
+      removeFreeCell(aboard, index);
+    } else if (old_code != BC_FREE_CELL && board_code == BC_FREE_CELL) {
+      addFreeCell(aboard, index);
+    }
+  }
+
+  // Store an entity on the board without displaying it
+  void setCellEntity(struct board* aboard, int y, int x, enum EntityTypes type) {
+    storeEntity(aboard, getCellIndex(aboard, y, x), y, x, type);
+  }
+
+  // Store an item on the board without displaying it.
+  // The cell gets the default entity type of the board code.
+  void setCellContent(struct board* aboard, int y, int x, enum BoardCodes board_code) {
+    setCellEntity(aboard, y, x, (enum EntityTypes) board_code);
+  }
+
+  // Show a symbol at position (y,x) of the display.
+  // The board may be larger than the display: only cells above the
+  // message area are shown.
+  static void drawSymbol(int y, int x, chtype symbol, enum ColorPairs color_pair) {
+    if (y >= LINES - ROWS_RESERVED || x >= COLS) {
+      return;
+    }
     // Store item on the display (symbol code)
     move(y, x);                         // Move cursor to (y,x)
     attron(COLOR_PAIR(color_pair));     // Start writing in selected color
@@ -31,79 +92,361 @@
     attroff(COLOR_PAIR(color_pair));    // Stop writing in selected color
   }
 
-  // Initialize the Level
-  enum ResCodes initializeLevel(struct board* aboard){
-    // define local variables for loops etc
+  // Place an item onto the board and the curses display.
+  void placeItem(struct board* aboard, int y, int x, enum BoardCodes board_code, chtype symbol, enum ColorPairs color_pair) {
+    setCellContent(aboard, y, x, board_code);
+    drawSymbol(y, x, symbol, color_pair);
+  }
+
+  // Store an item in the cell with the given index without displaying it.
+  // The bit planes need the position of the cell; the rest of the board
+  // works on the index.
+  void setContentOfCell(struct board* aboard, int index, enum BoardCodes board_code) {
+    struct pos position = getCellPosition(aboard, index);
+    storeEntity(aboard, index, position.y, position.x, (enum EntityTypes) board_code);
+  }
+
+  // Show a symbol at the cell with the given index; the board is not changed
+  void drawCell(struct board* aboard, int index, chtype symbol, enum ColorPairs color_pair) {
+    struct pos position = getCellPosition(aboard, index);
+    drawSymbol(position.y, position.x, symbol, color_pair);
+  }
+
+  // Place an entity onto the board and show it as given by its type
+  void placeEntity(struct board* aboard, int y, int x, enum EntityTypes type) {
+    setCellEntity(aboard, y, x, type);
+    drawSymbol(y, x, entity_behaviours[type].symbol, entity_behaviours[type].color);
+  }
+
+  // The character that shows a cell on the display
+  static inline chtype getCellGlyph(struct board* aboard, int y, int x) {
+    enum EntityTypes type = getCellType(*getCell(aboard, getCellIndex(aboard, y, x)));
+    return entity_behaviours[type].symbol | COLOR_PAIR(entity_behaviours[type].color);
+  }
+
+  // Show the cells with the given indices on the display as they are on
+  // the board now
+  void redrawCells(struct board* aboard, int* indices, int n) {
+    struct pos position;
+    enum EntityTypes type;
+    int i;
+
+    for (i = 0; i < n; i++) {
+      position = getCellPosition(aboard, indices[i]);
+      type = getCellType(*getCell(aboard, indices[i]));
+      drawSymbol(position.y, position.x, entity_behaviours[type].symbol, entity_behaviours[type].color);
+    }
+  }
+
+  // The separator line below the board tells whether the edges are open
+  static inline chtype getSeparatorGlyph(struct board* aboard) {
+    return (aboard->torus ? SYMBOL_TORUS_EDGE : SYMBOL_BARRIER) | COLOR_PAIR(COLP_BARRIER);
+  }
+
+  // Show the visible part of the board on the display.
+  // Worm elements are all shown as inner elements; showWorms() refines that.
+  void renderBoard(struct board* aboard) {
     int y;
     int x;
-    // Fill board and screen buffer with empty cells.
-    for(y = 0; y <= aboard->last_row ; y++){
-      for(x = 0; x <= aboard->last_col ; x++){
-        placeItem(aboard,y,x,BC_FREE_CELL,SYMBOL_FREE_CELL,COLP_FREE_CELL);
+    int last_y = aboard->last_row;
+    int last_x = aboard->last_col;
+
+    if (last_y > LINES - ROWS_RESERVED - 1) {
+      last_y = LINES - ROWS_RESERVED - 1;
+    }
+    if (last_x > COLS - 1) {
+      last_x = COLS - 1;
+    }
+    for(y = 0; y <= last_y; y++){
+      move(y, 0);
+      for(x = 0; x <= last_x; x++){
+        addch(getCellGlyph(aboard, y, x));
       }
     }
     // Draw a line in order to separate the message area
-    // Note: we cannot use function placeItem() since the message area
-    // is outside the board!
-    y = aboard->last_row + 1;
-    for(x = 0; x <= aboard->last_col; x++){
-      move(y,x);
-      attron(COLOR_PAIR(COLP_BARRIER));
-      addch(SYMBOL_BARRIER);
-      attroff(COLOR_PAIR(COLP_BARRIER));
+    // Note: the message area is outside the board!
+    // If the board is larger than the display the line is drawn at the
+    // bottom of the display.
+    y = last_y + 1;
+    move(y, 0);
+    for(x = 0; x <= last_x; x++){
+      addch(getSeparatorGlyph(aboard));
+    }
+  }
+
+  // Size of the part of the board shown in a window of
+  // window_rows x window_cols cells for the board
+  void getScreenSize(struct board* aboard, int window_rows, int window_cols,
+                     int* ascreen_rows, int* ascreen_cols) {
+    *ascreen_rows = aboard->last_row + 1 < window_rows ? aboard->last_row + 1 : window_rows;
+    *ascreen_cols = aboard->last_col + 1 < window_cols ? aboard->last_col + 1 : window_cols;
+  }
+
+  // Render the visible part of the board as renderBoard() does, but into
+  // the buffer screen instead of the display: screen_rows rows of the board
+  // and the separator line, each screen_cols characters wide.
+  // Does not call curses, so it may run in any thread.
+  void prerenderBoard(struct board* aboard, chtype* screen, int screen_rows, int screen_cols) {
+    int y;
+    int x;
+
+    for(y = 0; y < screen_rows; y++){
+      for(x = 0; x < screen_cols; x++){
+        *screen++ = getCellGlyph(aboard, y, x);
+      }
+    }
+    for(x = 0; x < screen_cols; x++){
+      *screen++ = getSeparatorGlyph(aboard);
+    }
+  }
+
+  // Copy a buffer filled by prerenderBoard() to the display, one row per call
+  void showPrerenderedBoard(chtype* screen, int screen_rows, int screen_cols) {
+    int y;
+
+    for(y = 0; y <= screen_rows; y++){
+      mvaddchnstr(y, 0, screen + (size_t) y * screen_cols, screen_cols);
+    }
+  }
+
+  // Initialize the Level
+  // The built-in level; other levels are read from files (see level_file.c).
+  // Only the board is set up here; call renderBoard() to show it.
+  enum ResCodes initializeLevel(struct board* aboard){
+    // define local variables for loops etc
+    int y;
+    int x;
+
+    // The layout needs a board of the guaranteed size
+    if(aboard->last_row + 1 < MIN_NUMBER_OF_ROWS || aboard->last_col + 1 < MIN_NUMBER_OF_COLS) {
+      return RES_FAILED;
     }
+    // Note: initializeBoard() has filled the board with empty cells.
+
     // Draw a line to signal the rightmost column of the board.
     for(y = 0; y <= aboard->last_row; y++){
-      x = aboard->last_col; // Test
-      placeItem(aboard,y,x,BC_BARRIER,SYMBOL_BARRIER,COLP_BARRIER);
+      x = aboard->last_col;
+      setCellContent(aboard,y,x,BC_BARRIER);
     }
     // Draw a barrier in the left third of the board
     for(y = 12; y <= 20; y++){
       x = aboard->last_col / 3;
-      placeItem(aboard,y,x,BC_BARRIER,SYMBOL_BARRIER,COLP_BARRIER);
+      setCellContent(aboard,y,x,BC_BARRIER);
     }
     // Draw a barrier in the right third of the board
     for(y = 7; y <= 17; y++){
       x = aboard->last_col / 3 * 2;
-      placeItem(aboard,y,x,BC_BARRIER,SYMBOL_BARRIER,COLP_BARRIER);
+      setCellContent(aboard,y,x,BC_BARRIER);
     }
     // Food
-    placeItem(aboard,3,3,BC_FOOD_1,SYMBOL_FOOD_1,COLP_FOOD_1);
-    placeItem(aboard,5,15,BC_FOOD_1,SYMBOL_FOOD_1,COLP_FOOD_1);
-    placeItem(aboard,17,5,BC_FOOD_2,SYMBOL_FOOD_2,COLP_FOOD_2);
-    placeItem(aboard,3,6,BC_FOOD_2,SYMBOL_FOOD_2,COLP_FOOD_2);
-    placeItem(aboard,4,37,BC_FOOD_2,SYMBOL_FOOD_2,COLP_FOOD_2);
-    placeItem(aboard,10,50,BC_FOOD_2,SYMBOL_FOOD_2,COLP_FOOD_2);
-    placeItem(aboard,29,20,BC_FOOD_3,SYMBOL_FOOD_3,COLP_FOOD_3);
-    placeItem(aboard,21,56,BC_FOOD_3,SYMBOL_FOOD_3,COLP_FOOD_3);
-    placeItem(aboard,5,7,BC_FOOD_3,SYMBOL_FOOD_3,COLP_FOOD_3);
-    placeItem(aboard,6,57,BC_FOOD_3,SYMBOL_FOOD_3,COLP_FOOD_3);
-
-    // Initialize number of food items
-    // Attention: must match number of items place on the board above
-    aboard->food_items = 10;
-    
+    setCellContent(aboard,3,3,BC_FOOD_1);
+    setCellContent(aboard,5,15,BC_FOOD_1);
+    setCellContent(aboard,17,5,BC_FOOD_2);
+    setCellContent(aboard,3,6,BC_FOOD_2);
+    setCellContent(aboard,4,37,BC_FOOD_2);
+    setCellContent(aboard,10,50,BC_FOOD_2);
+    setCellContent(aboard,23,20,BC_FOOD_3);
+    setCellContent(aboard,21,56,BC_FOOD_3);
+    setCellContent(aboard,5,7,BC_FOOD_3);
+    setCellContent(aboard,6,57,BC_FOOD_3);
+
+    // Note: the number of food items is counted by placeItem()
+
     return RES_OK;
   }
 
+  // Pick a free cell uniformly at random.
+  // Returns false if there is no free cell left.
+  bool pickRandomFreeCell(struct board* aboard, struct rng* arng, struct pos* found) {
+    if (aboard->free_count == 0) {
+      return false;
+    }
+    *found = getCellPosition(aboard,
+        aboard->free_cells[nextRandomBelow(arng, aboard->free_count)]);
+    return true;
+  }
+
+  // Place new food at random free cells until there are as many food items
+  // of each type as given by food_target
+  void replenishFood(struct board* aboard, struct rng* arng,
+                     int food_target[NUMBER_OF_FOOD_TYPES]) {
+    int t;
+    struct pos position;
+
+    for (t = 0; t < NUMBER_OF_FOOD_TYPES; t++) {
+      while (aboard->food_items_of_type[t] < food_target[t]
+             && pickRandomFreeCell(aboard, arng, &position)) {
+        placeEntity(aboard, position.y, position.x, ET_FOOD_1 + t);
+      }
+    }
+  }
+
+  // Length of a stored row including the ring cells on the left and right
+  static int computeStride(int cols) {
+#ifdef BOARD_LAYOUT_TILED
+    // The tiled layout needs a power of two, see getCellOffset()
+    int stride = BOARD_TILE_SIZE;
+    while(stride < cols + 2){
+      stride <<= 1;
+    }
+    return stride;
+#else
+    return cols + 2;
+#endif
+  }
+
+  // Number of stored rows including the ring rows at the top and bottom
+  static int computeStoredRows(int rows) {
+#ifdef BOARD_LAYOUT_TILED
+    // Only whole tiles are stored
+    return (rows + 2 + BOARD_TILE_SIZE - 1) & ~(BOARD_TILE_SIZE - 1);
+#else
+    return rows + 2;
+#endif
+  }
+
+  // Set the dimensions of the board and place all its arrays inside one
+  // block of storage. With storage == NULL only the size is computed.
+  // The same layout is used for boards in the arena of a level and for
+  // boards mapped from binary level files (see level_image.c).
+  // Returns the size of the block in bytes.
+  static size_t layoutBoardStorage(struct board* aboard, int rows, int cols, char* storage) {
+    size_t stored_cells;
+    size_t offset = 0;
+    int p;
+
+    // Maximal index of a row
+    aboard->last_row = rows -1;
+    // Maximal index of a column
+    aboard->last_col = cols -1;
+
+    // Plain board with four headings by default;
+    // wrapping is cheaper for powers of two
+    aboard->torus = false;
+    aboard->diagonal = false;
+    aboard->row_mask = (rows & (rows - 1)) == 0 ? rows - 1 : 0;
+    aboard->col_mask = (cols & (cols - 1)) == 0 ? cols - 1 : 0;
+
+    // Length of a stored row including the ring cells on the left and right
+    aboard->stride = computeStride(cols);
+    aboard->stride_bits = __builtin_ctz(aboard->stride);
+    aboard->words_per_row = getPlaneWordsPerRow(cols);
+
+    // The cells including the ring of BC_OUT_OF_BOUNDS cells around the board
+    stored_cells = (size_t) computeStoredRows(rows) * aboard->stride;
+    aboard->cells = (uint8_t*) (storage + offset);
+    offset += getArenaPieceSize(stored_cells * sizeof(uint8_t));
+
+    // The bit planes
+    for(p = 0; p < BP_NUMBER_OF_PLANES; p++){
+      aboard->planes[p] = (uint64_t*) (storage + offset);
+      offset += getPlaneStorageSize(rows, cols);
+    }
+
+    // The set of free cells
+    aboard->free_cells = (int*) (storage + offset);
+    offset += getArenaPieceSize((size_t) rows * cols * sizeof(int));
+    aboard->free_slot = (int*) (storage + offset);
+    offset += getArenaPieceSize(stored_cells * sizeof(int));
+
+    aboard->storage = storage;
+    aboard->storage_size = offset;
+    return offset;
+  }
+
+  // Number of bytes the board needs in the arena of a level
+  size_t getBoardStorageSize(int rows, int cols) {
+    struct board dummy;
+    return layoutBoardStorage(&dummy, rows, cols, NULL);
+  }
+
+  // Number of bytes of the array cells, including the ring and, with the
+  // tiled layout, the unused cells of the tiles at the bottom
+  size_t getNumberOfStoredCells(struct board* aboard) {
+    return (size_t) computeStoredRows(aboard->last_row + 1) * aboard->stride;
+  }
+
+  // Use a block of storage that already holds a complete board
+  // (e.g. a mapped binary level file) without copying it.
+  // The block must have been laid out for a board of the same dimensions
+  // by the same build. The scalar fields (food counters, number of free
+  // cells, start position) are not part of the block and must be set by
+  // the caller.
+  void attachBoardStorage(struct board* aboard, int rows, int cols, void* storage) {
+    layoutBoardStorage(aboard, rows, cols, storage);
+  }
+
   // Initialize the Board
-  enum ResCodes initializeBoard(struct board* aboard) {
+  enum ResCodes initializeBoard(struct board* aboard, struct arena* aarena, int rows, int cols) {
+    int y;
+    int x;
+    int p;
+    int index;
+    char* storage;
+    size_t stored_cells;
+
     // Check dimensions of the board
-    if(COLS<MIN_NUMBER_OF_COLS || LINES<MIN_NUMBER_OF_ROWS + ROWS_RESERVED) {
-      char buf[100];
-        sprintf(buf, "Das Fenster ist zu klein: wir brauchen %dx%d",
-            MIN_NUMBER_OF_COLS, MIN_NUMBER_OF_ROWS + ROWS_RESERVED);
-        showDialog(buf, "Bitte eine Taste druecken");
-        return RES_FAILED;
-  }
-  // Maximal index of a row
-  aboard->last_row = MIN_NUMBER_OF_ROWS -1;
-  // Maximal index of a column
-  aboard->last_col = MIN_NUMBER_OF_COLS -1;
-  return RES_OK;
+    // Note: the board model does not talk to the user; the caller does.
+    if(cols < 1 || rows < 1 || (long long) rows * cols > MAX_NUMBER_OF_CELLS) {
+      return RES_FAILED;
+    }
+
+    // Get all arrays of the board from the arena of the level in one block.
+    // The arena is zeroed; this matches bit planes of a board of free cells.
+    storage = allocFromArena(aarena, getBoardStorageSize(rows, cols));
+    if(storage == NULL) {
+      return RES_FAILED;
+    }
+    layoutBoardStorage(aboard, rows, cols, storage);
+
+    // The worm starts at the left border unless the level says otherwise
+    aboard->start_pos.y = aboard->last_row / 2;
+    aboard->start_pos.x = 0;
+
+    // No food yet
+    aboard->food_items = 0;
+    for(p = 0; p < NUMBER_OF_FOOD_TYPES; p++){
+      aboard->food_items_of_type[p] = 0;
+    }
+
+    // No free cells yet
+    stored_cells = (size_t) computeStoredRows(rows) * aboard->stride;
+    aboard->free_count = 0;
+    memset(aboard->free_slot, -1, stored_cells * sizeof(int));
+
+    // Surround the board by a ring of BC_OUT_OF_BOUNDS cells:
+    // mark all stored cells as out of bounds and free the cells inside the ring.
+    // The contents of the board are set by initializeLevel().
+    memset(aboard->cells, BOARD_CELL(BC_OUT_OF_BOUNDS), stored_cells * sizeof(uint8_t));
+    for(y = 0; y < rows; y++){
+      for(x = 0; x < cols; x++){
+        index = getCellIndex(aboard, y, x);
+        *getCell(aboard, index) = BOARD_CELL(BC_FREE_CELL);
+        addFreeCell(aboard, index);
+      }
+    }
+    return RES_OK;
+  }
+
+// Make the board a torus or a plain board
+void setBoardTorus(struct board* aboard, bool torus) {
+  aboard->torus = torus;
+}
+
+// Allow or forbid diagonal moves on the board
+void setBoardDiagonal(struct board* aboard, bool diagonal) {
+  aboard->diagonal = diagonal;
 }
 
 // Getters
+bool isBoardTorus(struct board* aboard) {
+  return aboard->torus;
+}
+
+bool isBoardDiagonal(struct board* aboard) {
+  return aboard->diagonal;
+}
+
 // Get the last usable row on the display
 int getLastRowOnBoard(struct board* aboard) {
   return aboard->last_row;
@@ -116,20 +459,23 @@ int getLastColOnBoard(struct board* aboard) {
 int getNumberOfFoodItems(struct board* aboard) {
   return aboard->food_items;
 }
+// Get the start position of the worm
+struct pos getStartPosition(struct board* aboard) {
+  return aboard->start_pos;
+}
+// Get the number of free cells on board
+int getNumberOfFreeCells(struct board* aboard) {
+  return aboard->free_count;
+}
+// Get the number of Food Items of one type on board
+int getNumberOfFoodItemsOfType(struct board* aboard, enum BoardCodes food_code) {
+  return aboard->food_items_of_type[food_code - BC_FOOD_1];
+}
 // Get Content at specified Position
 enum BoardCodes getContentAt(struct board* aboard, struct pos position) {
-  return aboard->cells[position.y][position.x];
-}
-
-// Setters
-// Set the number of food items
-void setNumberOfFoodItems(struct board* aboard, int n){
-  aboard->food_items = n; // Nicht sicher
+  return getContentOfCell(aboard, getCellIndex(aboard, position.y, position.x));
 }
-// decrease the number of Food items by one
-void decrementNumberOfFoodItems(struct board* aboard){
-  aboard->food_items--;
+// Get the type of the entity at specified Position
+enum EntityTypes getEntityTypeAt(struct board* aboard, struct pos position) {
+  return getEntityTypeOfCell(aboard, getCellIndex(aboard, position.y, position.x));
 }
-
-
-
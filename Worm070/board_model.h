@@ -13,7 +13,12 @@
 #define _BOARD_MODEL_H
 
 #include <curses.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "worm.h"
+#include "arena.h"
+#include "rng.h"
 
 // Codes on the board
 enum BoardCodes {
@@ -22,9 +27,79 @@ enum BoardCodes {
     BC_FOOD_1,       // Food type 1; if hit by worm -> bonus of type 1
     BC_FOOD_2,       // Food type 2; if hit by worm -> bonus of type 2
     BC_FOOD_3,       // Food type 3; if hit by worm -> bonus of type 3
-    BC_BARRIER       // A barrier; if hit by worm -> game over
+    BC_BARRIER,      // A barrier; if hit by worm -> game over
+    BC_OUT_OF_BOUNDS // Cell of the ring around the board; if hit by worm -> game over
 };
 
+// Food codes are consecutive
+#define NUMBER_OF_FOOD_TYPES (BC_FOOD_3 - BC_FOOD_1 + 1)
+
+static inline bool isFoodCode(enum BoardCodes board_code) {
+  return board_code >= BC_FOOD_1 && board_code <= BC_FOOD_3;
+}
+
+// Types of the entities on the board.
+// The behaviour of each type (symbol, effect on a worm, lifetime) is given
+// by a table in entity.c; adding a type does not touch the game loop.
+// The first types match the board codes one to one; further types are
+// stored with the board code of a similar type (see entity_behaviours[]).
+enum EntityTypes {
+    ET_FREE_CELL,       // BC_FREE_CELL
+    ET_WORM,            // BC_USED_BY_WORM
+    ET_FOOD_1,          // BC_FOOD_1
+    ET_FOOD_2,          // BC_FOOD_2
+    ET_FOOD_3,          // BC_FOOD_3
+    ET_BARRIER,         // BC_BARRIER
+    ET_OUT_OF_BOUNDS,   // BC_OUT_OF_BOUNDS
+    ET_FLEETING_FOOD,   // Bonus food that vanishes after a while; BC_FOOD_3
+    ET_NUMBER_OF_TYPES
+};
+
+// Each cell of the board is stored in a single byte.
+// The lower bits hold one of the codes above, the upper bits the type of
+// the entity in the cell. The code alone is enough for the bit planes;
+// the type selects the behaviour.
+#define BC_CODE_MASK 0x07  // Bits of a cell holding the enum BoardCodes
+#define BC_TYPE_SHIFT 3    // Position of the enum EntityTypes in a cell
+
+// A cell holding the default type of a code
+#define BOARD_CELL(code) ((code) | ((code) << BC_TYPE_SHIFT))
+
+static inline enum EntityTypes getCellType(uint8_t cell) {
+  return cell >> BC_TYPE_SHIFT;
+}
+
+// The food counters of the board only count the food of the level.
+// Fleeting food is left out: the round ends without it being eaten.
+static inline bool isCountedFood(enum EntityTypes type) {
+  return type >= ET_FOOD_1 && type <= ET_FOOD_3;
+}
+
+// Layout of the cells in memory
+// By default the cells are stored row by row. If BOARD_LAYOUT_TILED is
+// defined (see Makefile) they are stored in square tiles of cells instead:
+// all cells of a tile are adjacent in memory and so are vertical neighbours.
+// This helps on boards with thousands of columns.
+// All accesses to cells go through getCell(), which hides the layout.
+#ifdef BOARD_LAYOUT_TILED
+#define BOARD_TILE_BITS 3                       // Tiles of 8x8 cells
+#define BOARD_TILE_SIZE (1 << BOARD_TILE_BITS)
+#endif
+
+// Bit planes kept alongside the cells.
+// Each plane has one bit per cell of the board; a bit is set if the cell
+// holds one of the codes belonging to the plane.
+enum BoardPlanes {
+    BP_BLOCKED,  // BC_BARRIER
+    BP_WORM,     // BC_USED_BY_WORM
+    BP_FOOD_1,   // BC_FOOD_1
+    BP_FOOD_2,   // BC_FOOD_2
+    BP_FOOD_3,   // BC_FOOD_3
+    BP_NUMBER_OF_PLANES
+};
+#define BP_MASK_ALL ((1 << BP_NUMBER_OF_PLANES) - 1) // Selects all planes
+#define BP_MASK_FOOD ((1 << BP_FOOD_1) | (1 << BP_FOOD_2) | (1 << BP_FOOD_3)) // All food planes
+
 // Positions on the board
 struct pos {
     int y;   // y-coordinate (row)
@@ -39,29 +114,183 @@ struct board
     int last_row; // Last usable row on the board
     int last_col; // Last usable column on the board
 
-    enum BoardCodes cells[MIN_NUMBER_OF_ROWS][MIN_NUMBER_OF_COLS];
+    char* storage;       // One block holding all arrays of the board
+    size_t storage_size; // Size of that block in bytes
+
+    struct pos start_pos; // Start position of the worm's head
+
+    bool torus;   // Leaving the board at an edge enters it at the opposite edge
+    bool diagonal; // Worms may move diagonally on this board
+    int row_mask; // last_row if the number of rows is a power of two, otherwise 0
+    int col_mask; // Same for the columns
+
+    int stride;      // Number of cells of a stored row including the ring: at least last_col + 3
+    int stride_bits; // Tiled layout only: stride == 1 << stride_bits
+
+    uint8_t* cells;
     // A 2-dimensional array for storing the contents of the board.
+    // The playable area is surrounded by a ring of BC_OUT_OF_BOUNDS cells,
+    // one cell wide. Hence, the neighbours of every cell of the board can be
+    // read without checking the bounds first.
+    // Cell (y,x) has the index (y + 1) * stride + (x + 1), see getCellIndex().
+    // Where a cell with a given index is stored depends on the layout of
+    // the board, see getCell().
+    // The array lives in the arena of the current level.
     //
     // Since the worm is not permitted to cross over itsself
     // nor other elements (apart from food) we do not need a reference
-    // counter for occupied cells.
+    // counter for occupied cells. Which worm uses a cell is kept by the
+    // worm model (see struct worm_set).
+
+    int words_per_row; // Number of 64-bit words of a row in each bit plane
 
-    int food_items; // Number of food items left in the current level
+    uint64_t* planes[BP_NUMBER_OF_PLANES];
+    // Bit planes of the board (see enum BoardPlanes).
+    // Bit x % 64 of word y * words_per_row + x / 64 belongs to cell (y,x).
+    // There is no ring around the planes; unused bits at the end of a row are 0.
+    // The planes are kept up to date by placeItem().
+    //
+    // Together with the counters below the food planes form an index of
+    // all food items on the board: they tell where the food of each type is.
+    // They are no spatial index, though. findNearestFood() searches the rows
+    // around a position, 64 cells per word, and only up to a given radius;
+    // its cost grows with that radius, not with the food on the board.
+    // Steered worms only look WORM_SCENT_RADIUS cells far for that reason.
+
+    int food_items; // Number of food items left in the current level (see isCountedFood())
+    int food_items_of_type[NUMBER_OF_FOOD_TYPES]; // Same, per type of food
+    // Both counters are maintained by placeItem(); never set them by hand.
+
+    int* free_cells; // Indices of all free cells in no particular order
+    int free_count;  // Number of valid entries in free_cells
+    int* free_slot;  // For each cell index: its position in free_cells or -1
+    // The set of free cells is maintained by placeItem() as well.
+    // A cell leaves the set by moving the last entry into its slot.
+    // Thus, adding, removing and picking a random free cell are O(1).
 };
 
-extern enum ResCodes initializeBoard(struct board* aboard);
+// Index of cell (y,x) in the array cells.
+// Valid for -1 <= y <= last_row + 1 and -1 <= x <= last_col + 1.
+static inline int getCellIndex(struct board* aboard, int y, int x) {
+  return (y + 1) * aboard->stride + (x + 1);
+}
+
+// Position of the cell with the given index
+static inline struct pos getCellPosition(struct board* aboard, int index) {
+  struct pos position;
+  position.y = index / aboard->stride - 1;
+  position.x = index % aboard->stride - 1;
+  return position;
+}
+
+// Index of the neighbour of the cell at index in direction (dy,dx)
+// with dy, dx from the set {-1,0,+1}
+static inline int getNeighbourIndex(struct board* aboard, int index, int dy, int dx) {
+  return index + dy * aboard->stride + dx;
+}
+
+// Difference of the indices of neighbouring cells in direction (dy,dx).
+// Precomputed once, a step from cell to cell is a single addition.
+static inline int getIndexDelta(struct board* aboard, int dy, int dx) {
+  return dy * aboard->stride + dx;
+}
+
+// Wrap coordinate v of a dimension with n cells into [0, n-1].
+// mask is n - 1 if n is a power of two, otherwise 0.
+// v must lie in [-n, 2n - 1], which is the case after a single step.
+static inline int wrapCoordinate(int v, int n, int mask) {
+  if (mask != 0) {
+    return v & mask;
+  }
+  return v + (n & -(v < 0)) - (n & -(v >= n));
+}
+
+// On a torus board: the position on the board a position just off the
+// board stands for. Other boards have no such positions.
+static inline struct pos getWrappedPosition(struct board* aboard, struct pos position) {
+  if (aboard->torus) {
+    position.y = wrapCoordinate(position.y, aboard->last_row + 1, aboard->row_mask);
+    position.x = wrapCoordinate(position.x, aboard->last_col + 1, aboard->col_mask);
+  }
+  return position;
+}
+
+// On a torus board: the index of the cell on the board a ring cell stands
+// for, see getWrappedPosition(). Only called after a step into the ring.
+static inline int getWrappedIndex(struct board* aboard, int index) {
+  struct pos position;
+
+  if (!aboard->torus) {
+    return index;
+  }
+  position = getWrappedPosition(aboard, getCellPosition(aboard, index));
+  return getCellIndex(aboard, position.y, position.x);
+}
+
+// Position of the cell with the given index in the array cells
+static inline size_t getCellOffset(struct board* aboard, int index) {
+#ifdef BOARD_LAYOUT_TILED
+  int y = index >> aboard->stride_bits;     // Row including the ring
+  int x = index & (aboard->stride - 1);     // Column including the ring
+  size_t tile = ((size_t) (y >> BOARD_TILE_BITS) << (aboard->stride_bits - BOARD_TILE_BITS))
+                + (x >> BOARD_TILE_BITS);
+  return (tile << (2 * BOARD_TILE_BITS))
+         | ((y & (BOARD_TILE_SIZE - 1)) << BOARD_TILE_BITS)
+         | (x & (BOARD_TILE_SIZE - 1));
+#else
+  (void) aboard;  // Only the tiled layout needs the board
+  return index;
+#endif
+}
+
+// The cell with the given index
+static inline uint8_t* getCell(struct board* aboard, int index) {
+  return &aboard->cells[getCellOffset(aboard, index)];
+}
+
+// Code and entity type of the cell with the given index
+static inline enum BoardCodes getContentOfCell(struct board* aboard, int index) {
+  return *getCell(aboard, index) & BC_CODE_MASK;
+}
+
+static inline enum EntityTypes getEntityTypeOfCell(struct board* aboard, int index) {
+  return getCellType(*getCell(aboard, index));
+}
+
+extern size_t getBoardStorageSize(int rows, int cols);
+extern size_t getNumberOfStoredCells(struct board* aboard);
+extern enum ResCodes initializeBoard(struct board* aboard, struct arena* aarena, int rows, int cols);
+extern void attachBoardStorage(struct board* aboard, int rows, int cols, void* storage);
+extern void setBoardTorus(struct board* aboard, bool torus);
+extern void setBoardDiagonal(struct board* aboard, bool diagonal);
+extern void setCellContent(struct board* aboard, int y, int x, enum BoardCodes board_code);
+extern void setCellEntity(struct board* aboard, int y, int x, enum EntityTypes type);
+extern void placeEntity(struct board* aboard, int y, int x, enum EntityTypes type);
 extern void placeItem(struct board* aboard, int y, int x, enum BoardCodes board_code,
                chtype symbol, enum ColorPairs color_pair);
+extern void setContentOfCell(struct board* aboard, int index, enum BoardCodes board_code);
+extern void drawCell(struct board* aboard, int index, chtype symbol, enum ColorPairs color_pair);
+extern void renderBoard(struct board* aboard);
+extern void redrawCells(struct board* aboard, int* indices, int n);
+extern void getScreenSize(struct board* aboard, int window_rows, int window_cols,
+                          int* ascreen_rows, int* ascreen_cols);
+extern void prerenderBoard(struct board* aboard, chtype* screen, int screen_rows, int screen_cols);
+extern void showPrerenderedBoard(chtype* screen, int screen_rows, int screen_cols);
 extern enum ResCodes initializeLevel(struct board* aboard);
+extern bool pickRandomFreeCell(struct board* aboard, struct rng* arng, struct pos* found);
+extern void replenishFood(struct board* aboard, struct rng* arng,
+                          int food_target[NUMBER_OF_FOOD_TYPES]);
 
 // Getters
 extern int getNumberOfFoodItems(struct board* aboard);
+extern int getNumberOfFoodItemsOfType(struct board* aboard, enum BoardCodes food_code);
+extern int getNumberOfFreeCells(struct board* aboard);
+extern struct pos getStartPosition(struct board* aboard);
 extern enum BoardCodes getContentAt(struct board* aboard, struct pos position);
+extern enum EntityTypes getEntityTypeAt(struct board* aboard, struct pos position);
+extern bool isBoardTorus(struct board* aboard);
+extern bool isBoardDiagonal(struct board* aboard);
 extern int getLastRowOnBoard(struct board* aboard);
 extern int getLastColOnBoard(struct board* aboard);
 
-// Setters
-extern void decrementNumberOfFoodItems(struct board* aboard);
-extern void setNumberOfFoodItems(struct board* aboard, int n);
-
 #endif  // #define _BOARD_MODEL_H
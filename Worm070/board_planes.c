@@ -0,0 +1,332 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Bit planes of the board and queries on them
+//
+// The queries look at 64 cells with a single word operation instead of
+// reading the cells one by one.
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "worm.h"
+#include "board_model.h"
+#include "board_planes.h"
+
+// The planes a cell with the given code belongs to
+static const uint8_t planes_of_code[] = {
+  [BC_FREE_CELL]     = 0,
+  [BC_USED_BY_WORM]  = 1 << BP_WORM,
+  [BC_FOOD_1]        = 1 << BP_FOOD_1,
+  [BC_FOOD_2]        = 1 << BP_FOOD_2,
+  [BC_FOOD_3]        = 1 << BP_FOOD_3,
+  [BC_BARRIER]       = 1 << BP_BLOCKED,
+  [BC_OUT_OF_BOUNDS] = 1 << BP_BLOCKED,
+};
+
+// The planes (a set of bits 1 << BP_...) a cell with the given code belongs to
+int getPlanesOfCode(enum BoardCodes code) {
+  return planes_of_code[code];
+}
+
+// Number of 64-bit words needed for one row of a plane
+int getPlaneWordsPerRow(int cols) {
+  return (cols + 63) / 64;
+}
+
+// Number of bytes one plane needs in the arena of a level
+size_t getPlaneStorageSize(int rows, int cols) {
+  return getArenaPieceSize((size_t) rows * getPlaneWordsPerRow(cols) * sizeof(uint64_t));
+}
+
+// Move the bit of cell (y,x) from the planes of old_code to those of new_code
+void updatePlanes(struct board* aboard, int y, int x,
+                  enum BoardCodes old_code, enum BoardCodes new_code) {
+  size_t word = (size_t) y * aboard->words_per_row + (x >> 6);
+  uint64_t bit = (uint64_t) 1 << (x & 63);
+  int old_planes = planes_of_code[old_code];
+  int new_planes = planes_of_code[new_code];
+  int p;
+
+  if (old_planes == new_planes) {
+    return;
+  }
+  for (p = 0; p < BP_NUMBER_OF_PLANES; p++) {
+    if (old_planes & (1 << p)) {
+      aboard->planes[p][word] &= ~bit;
+    }
+    if (new_planes & (1 << p)) {
+      aboard->planes[p][word] |= bit;
+    }
+  }
+}
+
+// Word i of the union of the planes selected by plane_mask
+static inline uint64_t getPlaneWord(struct board* aboard, int plane_mask, size_t i) {
+  uint64_t word = 0;
+  int p;
+
+  for (p = 0; p < BP_NUMBER_OF_PLANES; p++) {
+    if (plane_mask & (1 << p)) {
+      word |= aboard->planes[p][i];
+    }
+  }
+  return word;
+}
+
+// Find the leftmost cell of row y between x_from and x_to (both inclusive)
+// that is occupied (or not) in the selected planes.
+// The segment is clipped to the board.
+// Returns the column of the cell or -1 if there is none.
+int findInRowSegment(struct board* aboard, int plane_mask, bool occupied,
+                     int y, int x_from, int x_to) {
+  size_t row;
+  int w;
+  uint64_t bits;
+
+  if (x_from < 0) {
+    x_from = 0;
+  }
+  if (x_to > aboard->last_col) {
+    x_to = aboard->last_col;
+  }
+  if (y < 0 || y > aboard->last_row || x_from > x_to) {
+    return -1;
+  }
+
+  row = (size_t) y * aboard->words_per_row;
+  for (w = x_from >> 6; w <= x_to >> 6; w++) {
+    bits = getPlaneWord(aboard, plane_mask, row + w);
+    if (!occupied) {
+      bits = ~bits;
+    }
+    // Cut off the cells in front of x_from and behind x_to
+    if (w == x_from >> 6) {
+      bits &= ~(uint64_t) 0 << (x_from & 63);
+    }
+    if (w == x_to >> 6) {
+      bits &= ~(uint64_t) 0 >> (63 - (x_to & 63));
+    }
+    if (bits != 0) {
+      return (w << 6) + __builtin_ctzll(bits);
+    }
+  }
+  return -1;
+}
+
+// Find the rightmost cell of row y between x_from and x_to (both inclusive)
+// that is occupied (or not) in the selected planes, see findInRowSegment().
+static int findLastInRowSegment(struct board* aboard, int plane_mask, bool occupied,
+                                int y, int x_from, int x_to) {
+  size_t row;
+  int w;
+  uint64_t bits;
+
+  if (x_from < 0) {
+    x_from = 0;
+  }
+  if (x_to > aboard->last_col) {
+    x_to = aboard->last_col;
+  }
+  if (y < 0 || y > aboard->last_row || x_from > x_to) {
+    return -1;
+  }
+
+  row = (size_t) y * aboard->words_per_row;
+  for (w = x_to >> 6; w >= x_from >> 6; w--) {
+    bits = getPlaneWord(aboard, plane_mask, row + w);
+    if (!occupied) {
+      bits = ~bits;
+    }
+    if (w == x_from >> 6) {
+      bits &= ~(uint64_t) 0 << (x_from & 63);
+    }
+    if (w == x_to >> 6) {
+      bits &= ~(uint64_t) 0 >> (63 - (x_to & 63));
+    }
+    if (bits != 0) {
+      return (w << 6) + 63 - __builtin_clzll(bits);
+    }
+  }
+  return -1;
+}
+
+// Find a cell in row y between x_from and x_to of a torus board.
+// The segment may cross the left or the right edge; x_from and x_to
+// must lie within one board width of the board.
+// With last == false the first cell of the segment is returned,
+// otherwise the last one.
+static int findInWrappedRowSegment(struct board* aboard, int plane_mask, bool occupied,
+                                   int y, int x_from, int x_to, bool last) {
+  int cols = aboard->last_col + 1;
+  int (*find)(struct board*, int, bool, int, int, int) =
+      last ? findLastInRowSegment : findInRowSegment;
+  int x;
+
+  if (x_to - x_from + 1 >= cols) {
+    return find(aboard, plane_mask, occupied, y, 0, aboard->last_col);
+  }
+  x_from = wrapCoordinate(x_from, cols, aboard->col_mask);
+  x_to = wrapCoordinate(x_to, cols, aboard->col_mask);
+  if (x_from <= x_to) {
+    return find(aboard, plane_mask, occupied, y, x_from, x_to);
+  }
+  // The segment is [x_from, last_col] followed by [0, x_to]
+  if (last) {
+    x = findLastInRowSegment(aboard, plane_mask, occupied, y, 0, x_to);
+    return x >= 0 ? x : findLastInRowSegment(aboard, plane_mask, occupied, y, x_from, aboard->last_col);
+  }
+  x = findInRowSegment(aboard, plane_mask, occupied, y, x_from, aboard->last_col);
+  return x >= 0 ? x : findInRowSegment(aboard, plane_mask, occupied, y, 0, x_to);
+}
+
+// Find the cell of row y nearest to column x, at most h columns away.
+// Both sides of x are searched word by word, the right one first; on a tie
+// the left cell wins. On a torus board the row wraps around and h must not
+// exceed half the number of columns.
+// Returns the distance in columns and the column in *ax, or -1.
+static int findNearestInRow(struct board* aboard, int plane_mask, bool occupied,
+                            int y, int x, int h, int* ax) {
+  int cols = aboard->last_col + 1;
+  int dist = -1;
+  int right;
+  int left;
+
+  if (aboard->torus) {
+    // Half a row to the right, the cell opposite x belongs to the left side
+    right = findInWrappedRowSegment(aboard, plane_mask, occupied, y, x,
+                                    x + (h < cols / 2 ? h : (cols - 1) / 2), false);
+    if (right >= 0) {
+      dist = wrapCoordinate(right - x, cols, aboard->col_mask);
+      *ax = right;
+      h = dist;
+    }
+    if (h > 0) {
+      left = findInWrappedRowSegment(aboard, plane_mask, occupied, y, x - h, x - 1, true);
+      if (left >= 0 && (dist < 0 || wrapCoordinate(x - left, cols, aboard->col_mask) <= dist)) {
+        dist = wrapCoordinate(x - left, cols, aboard->col_mask);
+        *ax = left;
+      }
+    }
+    return dist;
+  }
+
+  right = findInRowSegment(aboard, plane_mask, occupied, y, x, x + h);
+  if (right >= 0) {
+    dist = right - x;
+    *ax = right;
+    h = dist;
+  }
+  if (h > 0) {
+    left = findLastInRowSegment(aboard, plane_mask, occupied, y, x - h, x - 1);
+    if (left >= 0 && (dist < 0 || x - left <= dist)) {
+      dist = x - left;
+      *ax = left;
+    }
+  }
+  return dist;
+}
+
+// Find the cell nearest to position from that is occupied (or not) in the
+// selected planes, at most max_r cells away. Distance is measured in rings
+// around from (chessboard distance). The search walks the rows outwards from
+// from.y and looks for the nearest cell of each row word by word; the rows
+// are only searched as far as the best cell found so far, and the search
+// stops once the rows are further away than that cell.
+// On a torus board rows and columns wrap around the edges and distances are
+// taken the short way round.
+// Returns false if there is no such cell within max_r.
+bool findNearestCellWithin(struct board* aboard, int plane_mask, bool occupied,
+                           struct pos from, int max_r, struct pos* found) {
+  int rows = aboard->last_row + 1;
+  int cols = aboard->last_col + 1;
+  int limit;
+  int max_d;
+  int max_h;
+  int best;
+  int dist;
+  int side;
+  int d;
+  int x;
+  int y;
+
+  if (aboard->torus) {
+    max_d = rows / 2;
+    max_h = cols / 2;
+  } else {
+    max_d = aboard->last_row;
+    max_h = aboard->last_col;
+  }
+  limit = max_d > max_h ? max_d : max_h;
+  if (max_r < limit) {
+    limit = max_r;
+  }
+
+  // The cell found so far is best rings away; rings beyond do not count
+  best = limit + 1;
+  for (d = 0; d <= max_d && d < best; d++) {
+    // The row above from first, then the one below
+    for (side = -1; side <= 1; side += 2) {
+      if (d == 0 && side > 0) {
+        break;
+      }
+      y = from.y + side * d;
+      if (aboard->torus) {
+        if (side > 0 && 2 * d == rows) {
+          break;  // The same row as above
+        }
+        y = wrapCoordinate(y, rows, aboard->row_mask);
+      } else if (y < 0 || y > aboard->last_row) {
+        continue;
+      }
+      dist = findNearestInRow(aboard, plane_mask, occupied, y, from.x,
+                              best - 1 < max_h ? best - 1 : max_h, &x);
+      if (dist >= 0) {
+        if (dist < d) {
+          dist = d;
+        }
+        if (dist < best) {
+          best = dist;
+          found->y = y;
+          found->x = x;
+        }
+      }
+    }
+  }
+  return best <= limit;
+}
+
+// Find the cell nearest to position from anywhere on the board,
+// see findNearestCellWithin()
+bool findNearestCell(struct board* aboard, int plane_mask, bool occupied,
+                     struct pos from, struct pos* found) {
+  return findNearestCellWithin(aboard, plane_mask, occupied, from, INT_MAX, found);
+}
+
+// Count the cells that hold neither barrier, worm nor food
+int countFreeCells(struct board* aboard) {
+  size_t n = (size_t) (aboard->last_row + 1) * aboard->words_per_row;
+  size_t i;
+  int occupied = 0;
+
+  for (i = 0; i < n; i++) {
+    occupied += __builtin_popcountll(getPlaneWord(aboard, BP_MASK_ALL, i));
+  }
+  return (aboard->last_row + 1) * (aboard->last_col + 1) - occupied;
+}
+
+// Find the free cell nearest to position from
+bool findNearestFreeCell(struct board* aboard, struct pos from, struct pos* found) {
+  return findNearestCell(aboard, BP_MASK_ALL, false, from, found);
+}
+
+// Find the food item nearest to position from, at most max_r cells away
+bool findNearestFood(struct board* aboard, struct pos from, int max_r, struct pos* found) {
+  return findNearestCellWithin(aboard, BP_MASK_FOOD, true, from, max_r, found);
+}
@@ -0,0 +1,42 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Bit planes of the board and queries on them
+
+#ifndef _BOARD_PLANES_H
+#define _BOARD_PLANES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "worm.h"
+#include "board_model.h"
+
+extern int getPlaneWordsPerRow(int cols);
+extern int getPlanesOfCode(enum BoardCodes code);
+extern size_t getPlaneStorageSize(int rows, int cols);
+extern void updatePlanes(struct board* aboard, int y, int x,
+                         enum BoardCodes old_code, enum BoardCodes new_code);
+
+// Queries
+// Each query works on the union of the planes selected by plane_mask
+// (a set of bits 1 << BP_...). With occupied == true it looks for cells
+// that are in one of the selected planes, otherwise for cells that are in none.
+extern int findInRowSegment(struct board* aboard, int plane_mask, bool occupied,
+                            int y, int x_from, int x_to);
+extern bool findNearestCellWithin(struct board* aboard, int plane_mask, bool occupied,
+                                  struct pos from, int max_r, struct pos* found);
+extern bool findNearestCell(struct board* aboard, int plane_mask, bool occupied,
+                            struct pos from, struct pos* found);
+
+extern int countFreeCells(struct board* aboard);
+extern bool findNearestFreeCell(struct board* aboard, struct pos from, struct pos* found);
+// Nearest food at most max_r cells away; the cost grows with max_r
+extern bool findNearestFood(struct board* aboard, struct pos from, int max_r, struct pos* found);
+
+#endif  // #define _BOARD_PLANES_H
@@ -0,0 +1,124 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Entities on the board: items and actors
+
+#include <curses.h>
+#include "worm.h"
+#include "worm_model.h"
+#include "entity.h"
+
+// What each entity type looks like and what it does to a worm.
+// Worms are shown element by element by showWorms(); the symbol here is
+// used when the board is drawn as a whole.
+const struct entity_behaviour entity_behaviours[ET_NUMBER_OF_TYPES] = {
+  [ET_FREE_CELL]     = {BC_FREE_CELL, SYMBOL_FREE_CELL, COLP_FREE_CELL,
+                        WORM_GAME_ONGOING, 0, 0},
+  [ET_WORM]          = {BC_USED_BY_WORM, SYMBOL_WORM_INNER_ELEMENT, COLP_USER_WORM,
+                        WORM_CROSSING, 0, 0},
+  [ET_FOOD_1]        = {BC_FOOD_1, SYMBOL_FOOD_1, COLP_FOOD_1,
+                        WORM_GAME_ONGOING, BONUS_1, 0},
+  [ET_FOOD_2]        = {BC_FOOD_2, SYMBOL_FOOD_2, COLP_FOOD_2,
+                        WORM_GAME_ONGOING, BONUS_2, 0},
+  [ET_FOOD_3]        = {BC_FOOD_3, SYMBOL_FOOD_3, COLP_FOOD_3,
+                        WORM_GAME_ONGOING, BONUS_3, 0},
+  [ET_BARRIER]       = {BC_BARRIER, SYMBOL_BARRIER, COLP_BARRIER,
+                        WORM_CRASH, 0, 0},
+  [ET_OUT_OF_BOUNDS] = {BC_OUT_OF_BOUNDS, SYMBOL_BARRIER, COLP_BARRIER,
+                        WORM_OUT_OF_BOUNDS, 0, 0},
+  [ET_FLEETING_FOOD] = {BC_FOOD_3, SYMBOL_FLEETING_FOOD, COLP_FOOD_3,
+                        WORM_GAME_ONGOING, BONUS_FLEETING, FLEETING_FOOD_LIFETIME},
+};
+
+// Number of bytes of the arena needed by an entity table
+size_t getEntityTableStorageSize(int capacity) {
+  return 4 * getArenaPieceSize((size_t) capacity * sizeof(int))
+      + getArenaPieceSize((size_t) capacity * sizeof(uint8_t));
+}
+
+// Get the arrays of the table from the arena of the level
+enum ResCodes initializeEntityTable(struct entity_table* atable, struct arena* aarena,
+                                    int capacity) {
+  atable->cell = allocFromArena(aarena, (size_t) capacity * sizeof(int));
+  atable->type = allocFromArena(aarena, (size_t) capacity * sizeof(uint8_t));
+  atable->timer = allocFromArena(aarena, (size_t) capacity * sizeof(int));
+  atable->owner = allocFromArena(aarena, (size_t) capacity * sizeof(int));
+  atable->changed = allocFromArena(aarena, (size_t) capacity * sizeof(int));
+  if (atable->cell == NULL || atable->type == NULL || atable->timer == NULL
+      || atable->owner == NULL || atable->changed == NULL) {
+    return RES_FAILED;
+  }
+  atable->count = 0;
+  atable->capacity = capacity;
+  atable->number_changed = 0;
+  return RES_OK;
+}
+
+// Place an entity of the given type at a random free cell and show it.
+// Entities with a lifetime are entered into the table.
+// Returns false if there is no free cell or the table is full.
+bool spawnEntity(struct entity_table* atable, struct board* aboard, struct rng* arng,
+                 enum EntityTypes type, int owner) {
+  struct pos position;
+  int lifetime = entity_behaviours[type].lifetime;
+
+  if (lifetime > 0 && atable->count == atable->capacity) {
+    return false;
+  }
+  if (!pickRandomFreeCell(aboard, arng, &position)) {
+    return false;
+  }
+  placeEntity(aboard, position.y, position.x, type);
+  if (lifetime > 0) {
+    atable->cell[atable->count] = getCellIndex(aboard, position.y, position.x);
+    atable->type[atable->count] = type;
+    atable->timer[atable->count] = lifetime;
+    atable->owner[atable->count] = owner;
+    atable->count++;
+  }
+  return true;
+}
+
+// Remove entry i of the table; the last entry takes over its slot
+static void removeEntry(struct entity_table* atable, int i) {
+  int last = atable->count - 1;
+
+  atable->cell[i] = atable->cell[last];
+  atable->type[i] = atable->type[last];
+  atable->timer[i] = atable->timer[last];
+  atable->owner[i] = atable->owner[last];
+  atable->count = last;
+}
+
+// Let one tick pass for all entities in the table.
+// Entities whose time is up vanish from the board; entities that are no
+// longer on the board (e.g. eaten by a worm) are dropped from the table.
+// The cells that changed are left in atable->changed for redrawCells().
+// Returns the number of changed cells.
+int updateEntities(struct entity_table* atable, struct board* aboard) {
+  struct pos position;
+  int i;
+
+  atable->number_changed = 0;
+  i = 0;
+  while (i < atable->count) {
+    atable->timer[i]--;
+    if (getCellType(*getCell(aboard, atable->cell[i])) != atable->type[i]) {
+      removeEntry(atable, i);
+    } else if (atable->timer[i] == 0) {
+      position = getCellPosition(aboard, atable->cell[i]);
+      setCellEntity(aboard, position.y, position.x, ET_FREE_CELL);
+      atable->changed[atable->number_changed++] = atable->cell[i];
+      removeEntry(atable, i);
+    } else {
+      i++;
+    }
+  }
+  return atable->number_changed;
+}
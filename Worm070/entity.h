@@ -0,0 +1,69 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Entities on the board: items and actors
+//
+// Each cell of the board holds the type of its entity (see enum
+// EntityTypes in board_model.h). What a type looks like and what it does
+// to a worm is given by the table entity_behaviours[]: a new type is one
+// more line in that table and needs no change of the game loop.
+//
+// Entities with a limited lifetime are also kept in an entity table.
+// The table stores one array per attribute (structure of arrays); the
+// update of each tick walks through these arrays from front to back.
+
+#ifndef _ENTITY_H
+#define _ENTITY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "worm.h"
+#include "arena.h"
+#include "board_model.h"
+#include "rng.h"
+
+#define ENTITY_CAPACITY 64          // Entities with a lifetime per level
+#define ENTITY_NO_OWNER -1          // Owner of entities not owned by a worm
+#define FLEETING_FOOD_LIFETIME 60   // Ticks until fleeting food vanishes
+#define FLEETING_FOOD_INTERVAL 100  // Ticks between two pieces of fleeting food
+
+// The behaviour of an entity type
+struct entity_behaviour {
+    enum BoardCodes code;    // Board code the type is stored with
+    chtype symbol;           // Symbol on the display
+    enum ColorPairs color;   // Color on the display
+    enum GameStates on_hit;  // State of a worm whose head runs into it
+    int growth;              // Elements a worm grows by when eating it
+    int lifetime;            // Ticks until it vanishes; 0 means forever
+};
+
+extern const struct entity_behaviour entity_behaviours[ET_NUMBER_OF_TYPES];
+
+// The entities with a lifetime on the board
+struct entity_table {
+    int* cell;       // Cell index of each entity (see getCellIndex())
+    uint8_t* type;   // Its enum EntityTypes
+    int* timer;      // Ticks until it vanishes
+    int* owner;      // Number of the owning worm or ENTITY_NO_OWNER
+    int count;       // Number of entities in the table
+    int capacity;    // Maximum number of entities
+
+    int* changed;       // Cells changed by the last update
+    int number_changed; // Number of cells in changed
+};
+
+extern size_t getEntityTableStorageSize(int capacity);
+extern enum ResCodes initializeEntityTable(struct entity_table* atable, struct arena* aarena,
+                                           int capacity);
+extern bool spawnEntity(struct entity_table* atable, struct board* aboard, struct rng* arng,
+                        enum EntityTypes type, int owner);
+extern int updateEntities(struct entity_table* atable, struct board* aboard);
+
+#endif  // #define _ENTITY_H
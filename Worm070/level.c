@@ -0,0 +1,211 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Setting up and releasing the data of a level
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "worm.h"
+#include "arena.h"
+#include "board_model.h"
+#include "worm_model.h"
+#include "entity.h"
+#include "level_file.h"
+#include "level_image.h"
+#include "level_gen.h"
+#include "level_script.h"
+#include "level.h"
+
+// Set up a level from a level image: the board stays in the mapped file
+static enum ResCodes setupLevelFromImage(struct level* alevel, const char* path) {
+  int rows;
+  int cols;
+
+  if (openLevelImage(&alevel->image, path, &rows, &cols) != RES_OK) {
+    strcpy(alevel->error, alevel->image.error);
+    return RES_FAILED;
+  }
+  // The arena only holds the entity table
+  if (initializeArena(&alevel->arena, getEntityTableStorageSize(ENTITY_CAPACITY)) != RES_OK) {
+    strcpy(alevel->error, "Kein Speicher fuer das Level");
+    closeLevelImage(&alevel->image);
+    return RES_FAILED;
+  }
+  attachLevelImage(&alevel->image, &alevel->board);
+  return RES_OK;
+}
+
+// Get the memory of a level and set up its board.
+// The level is read from the file given in the settings (a text level
+// or a level image) or generated from the seed in the settings;
+// otherwise the built-in level is used.
+// Nothing is displayed here; on failure a message is left in alevel->error.
+// On success the caller must release the level by releaseLevel().
+enum ResCodes setupLevel(struct level* alevel, struct game_settings* asettings) {
+  struct level_file level_file; // The mapped level file, if any
+  int rows = asettings->rows;
+  int cols = asettings->cols;
+  enum ResCodes res_code;
+
+  alevel->image.map = NULL;
+  alevel->error[0] = '\0';
+  initializeLevelScripts(&alevel->scripts);
+
+  if (asettings->level_path != NULL && isLevelImage(asettings->level_path)) {
+    res_code = setupLevelFromImage(alevel, asettings->level_path);
+    if (res_code == RES_OK && asettings->torus) {
+      setBoardTorus(&alevel->board, true);
+    }
+    if (res_code == RES_OK && asettings->diagonal) {
+      setBoardDiagonal(&alevel->board, true);
+    }
+    return res_code;
+  }
+
+  // The dimensions of the board are given by the level file
+  if (asettings->level_path != NULL) {
+    if (openLevelFile(&level_file, asettings->level_path) != RES_OK) {
+      strcpy(alevel->error, level_file.error);
+      return RES_FAILED;
+    }
+    rows = level_file.rows;
+    cols = level_file.cols;
+  }
+
+  // Get all memory of the level in one piece: the board and the entity table.
+  // The worms keep their own memory, see initializeWorms().
+  res_code = initializeArena(&alevel->arena,
+      getBoardStorageSize(rows, cols) + getEntityTableStorageSize(ENTITY_CAPACITY));
+  if (res_code == RES_OK) {
+    res_code = initializeBoard(&alevel->board, &alevel->arena, rows, cols);
+    if (res_code != RES_OK) {
+      releaseArena(&alevel->arena);
+    }
+  }
+  if (res_code != RES_OK) {
+    strcpy(alevel->error, "Kein Speicher fuer das Spielfeld");
+    if (asettings->level_path != NULL) {
+      closeLevelFile(&level_file);
+    }
+    return res_code;
+  }
+
+  // Initialize the current Level.
+  // A level file may ask for a torus board or diagonal moves on its own.
+  setBoardTorus(&alevel->board, asettings->torus);
+  setBoardDiagonal(&alevel->board, asettings->diagonal);
+  if (asettings->level_path != NULL) {
+    res_code = loadLevelFile(&level_file, &alevel->board);
+    if (res_code != RES_OK) {
+      strcpy(alevel->error, level_file.error);
+    } else {
+      // The scripts put their objects onto the board, too
+      res_code = compileLevelScripts(&alevel->scripts, &alevel->board,
+          level_file.data + level_file.scripts, level_file.data + level_file.size,
+          level_file.scripts_line, level_file.path, alevel->error);
+    }
+    closeLevelFile(&level_file);
+  } else if (asettings->generate) {
+    generateLevel(&alevel->board, asettings->seed);
+  } else {
+    res_code = initializeLevel(&alevel->board);
+    if (res_code != RES_OK) {
+      sprintf(alevel->error, "Das Spielfeld ist zu klein: wir brauchen %dx%d",
+          MIN_NUMBER_OF_COLS, MIN_NUMBER_OF_ROWS);
+    }
+  }
+  if (res_code != RES_OK) {
+    releaseArena(&alevel->arena);
+  }
+  return res_code;
+}
+
+// Release all memory of a level in one go
+void releaseLevel(struct level* alevel) {
+  releaseArena(&alevel->arena);
+  releaseLevelScripts(&alevel->scripts);
+  closeLevelImage(&alevel->image);
+}
+
+// ************************************
+// Batch generation of level images
+// ************************************
+
+// Work shared by all threads of a batch
+struct level_batch {
+    struct game_settings* settings; // Size, first seed and path prefix
+    atomic_int next;   // Index of the next level to generate
+    atomic_int failed; // Number of levels that could not be written
+};
+
+// Generate and write levels until the batch is done.
+// Each level only depends on its seed, not on the thread doing the work.
+static void* runLevelBatch(void* abatch) {
+  struct level_batch* batch = abatch;
+  struct game_settings settings = *batch->settings;
+  struct level thelevel;
+  char path[PATH_MAX_LENGTH];
+  uint64_t hash;
+  int i;
+
+  while ((i = atomic_fetch_add(&batch->next, 1)) < settings.batch_count) {
+    settings.seed = batch->settings->seed + i;
+    if (setupLevel(&thelevel, &settings) != RES_OK) {
+      fprintf(stderr, "Seed %llu: %s\n", (unsigned long long) settings.seed, thelevel.error);
+      atomic_fetch_add(&batch->failed, 1);
+      continue;
+    }
+    snprintf(path, sizeof(path), "%s-%llu", settings.image_path,
+        (unsigned long long) settings.seed);
+    if (writeLevelImage(&thelevel.board, path, &hash, thelevel.error) != RES_OK) {
+      fprintf(stderr, "%s\n", thelevel.error);
+      atomic_fetch_add(&batch->failed, 1);
+    }
+    releaseLevel(&thelevel);
+  }
+  return NULL;
+}
+
+// Generate asettings->batch_count levels with consecutive seeds and write
+// them as level images <image_path>-<seed>, using all processors.
+// Returns the number of levels that could not be written.
+int writeLevelImages(struct game_settings* asettings) {
+  struct level_batch batch;
+  pthread_t threads[MAX_BATCH_THREADS];
+  long number_of_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  long started;
+  long t;
+
+  batch.settings = asettings;
+  atomic_init(&batch.next, 0);
+  atomic_init(&batch.failed, 0);
+
+  if (number_of_threads > MAX_BATCH_THREADS) {
+    number_of_threads = MAX_BATCH_THREADS;
+  }
+  if (number_of_threads > asettings->batch_count) {
+    number_of_threads = asettings->batch_count;
+  }
+  // If no thread can be started, the calling thread does all the work
+  for (started = 0; started < number_of_threads; started++) {
+    if (pthread_create(&threads[started], NULL, runLevelBatch, &batch) != 0) {
+      break;
+    }
+  }
+  if (started == 0) {
+    runLevelBatch(&batch);
+  }
+  for (t = 0; t < started; t++) {
+    pthread_join(threads[t], NULL);
+  }
+  return atomic_load(&batch.failed);
+}
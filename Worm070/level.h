@@ -0,0 +1,39 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Setting up and releasing the data of a level
+
+#ifndef _LEVEL_H
+#define _LEVEL_H
+
+#include "worm.h"
+#include "arena.h"
+#include "board_model.h"
+#include "level_file.h"
+#include "level_image.h"
+#include "level_script.h"
+
+#define MAX_BATCH_THREADS 256  // Upper bound for the threads of a batch
+#define PATH_MAX_LENGTH 4096   // Size of buffers for file names
+
+// All data of a level
+struct level {
+    struct arena arena;  // Memory of the level: the board (unless it is mapped
+                         // from a level image) and the entity table
+    struct board board;  // The game board
+    struct level_image image; // Mapped level image; image.map == NULL if none
+    struct level_scripts scripts; // Moving barriers of the level (text level files only)
+    char error[LEVEL_ERROR_LENGTH]; // Reason why the level could not be set up
+};
+
+extern enum ResCodes setupLevel(struct level* alevel, struct game_settings* asettings);
+extern void releaseLevel(struct level* alevel);
+extern int writeLevelImages(struct game_settings* asettings);
+
+#endif  // #define _LEVEL_H
@@ -0,0 +1,240 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Validation of levels: which cells can the worm reach from its start?
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "worm.h"
+#include "board_model.h"
+#include "level_check.h"
+
+// Spread the bits of reach to the left and to the right along runs of
+// open cells within a row. Shifts by 1, 2, 4, ... 32 cover a word in six
+// steps; the last bit is carried over into the neighbouring word.
+static void fillRowOnce(uint64_t* reach, const uint64_t* open, int words) {
+  uint64_t r;
+  uint64_t o;
+  uint64_t carry;
+  int s;
+  int w;
+
+  // To the right: higher columns, word by word from the left
+  carry = 0;
+  for (w = 0; w < words; w++) {
+    o = open[w];
+    r = reach[w] | (carry & o);
+    for (s = 1; s < 64; s <<= 1) {
+      r |= (r << s) & o;
+      o &= o << s;
+    }
+    reach[w] = r;
+    carry = r >> 63;
+  }
+  // To the left: lower columns, word by word from the right
+  carry = 0;
+  for (w = words - 1; w >= 0; w--) {
+    o = open[w];
+    r = reach[w] | ((carry << 63) & o);
+    for (s = 1; s < 64; s <<= 1) {
+      r |= (r >> s) & o;
+      o &= o >> s;
+    }
+    reach[w] = r;
+    carry = r & 1;
+  }
+}
+
+// Spread the reachable cells of a row. On a torus board a run of open
+// cells may go on at the other edge; then the row is filled once more.
+static void fillRow(uint64_t* reach, const uint64_t* open, int words, int cols, bool torus) {
+  int last_word = (cols - 1) >> 6;
+  uint64_t last_bit = (uint64_t) 1 << ((cols - 1) & 63);
+  uint64_t before;
+
+  fillRowOnce(reach, open, words);
+  if (!torus) {
+    return;
+  }
+  before = (reach[0] & 1) | ((reach[last_word] & last_bit) ? 2 : 0);
+  if ((reach[last_word] & last_bit) && (open[0] & 1)) {
+    reach[0] |= 1;
+  }
+  if ((reach[0] & 1) && (open[last_word] & last_bit)) {
+    reach[last_word] |= last_bit;
+  }
+  if (before != ((reach[0] & 1) | ((reach[last_word] & last_bit) ? 2 : 0))) {
+    fillRowOnce(reach, open, words);
+  }
+}
+
+// Take over the reachable cells of a neighbouring row and spread them.
+// Returns true if row y has got new reachable cells.
+static bool updateRow(uint64_t* reach, const uint64_t* open, int words, int cols, bool torus,
+                      int y, int from_y) {
+  uint64_t* row = reach + (size_t) y * words;
+  const uint64_t* from_row = reach + (size_t) from_y * words;
+  const uint64_t* open_row = open + (size_t) y * words;
+  bool changed = false;
+  int w;
+
+  for (w = 0; w < words; w++) {
+    if (from_row[w] & open_row[w] & ~row[w]) {
+      changed = true;
+    }
+  }
+  if (!changed) {
+    return false;
+  }
+  for (w = 0; w < words; w++) {
+    row[w] |= from_row[w] & open_row[w];
+  }
+  fillRow(row, open_row, words, cols, torus);
+  return true;
+}
+
+// Count the open cells of a row with at most one open neighbour
+static int countDeadEnds(const uint64_t* reach, const uint64_t* open, int words,
+                         int y, int rows, int cols, bool torus) {
+  const uint64_t* row = open + (size_t) y * words;
+  const uint64_t* row_above = NULL;
+  const uint64_t* row_below = NULL;
+  int last_word = (cols - 1) >> 6;
+  int last_shift = (cols - 1) & 63;
+  int dead_ends = 0;
+  int w;
+
+  // The neighbours beyond the edges: none, or those at the other edge
+  if (y > 0 || torus) {
+    row_above = open + (size_t) (y > 0 ? y - 1 : rows - 1) * words;
+  }
+  if (y < rows - 1 || torus) {
+    row_below = open + (size_t) (y < rows - 1 ? y + 1 : 0) * words;
+  }
+  for (w = 0; w < words; w++) {
+    uint64_t up = row_above != NULL ? row_above[w] : 0;
+    uint64_t down = row_below != NULL ? row_below[w] : 0;
+    uint64_t left = (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+    uint64_t right = (row[w] >> 1) | (w < words - 1 ? row[w + 1] << 63 : 0);
+
+    if (torus && w == 0) {
+      left |= (row[last_word] >> last_shift) & 1;
+    }
+    if (torus && w == last_word) {
+      right |= (row[0] & 1) << last_shift;
+    }
+    // At most one of the four neighbours is open
+    uint64_t two_or_more = (up & down) | (up & left) | (up & right)
+                         | (down & left) | (down & right) | (left & right);
+
+    dead_ends += __builtin_popcountll(reach[(size_t) y * words + w] & ~two_or_more);
+  }
+  return dead_ends;
+}
+
+// Flood fill the board from the start position and gather the results.
+// Sweeps alternate downwards and upwards until no row changes any more;
+// each sweep handles all rows word by word.
+// On success the caller must call releaseLevelCheck().
+enum ResCodes checkLevel(struct board* aboard, struct level_check* acheck) {
+  int rows = aboard->last_row + 1;
+  int cols = aboard->last_col + 1;
+  bool torus = isBoardTorus(aboard);
+  int words = aboard->words_per_row;
+  size_t n = (size_t) rows * words;
+  uint64_t* open;
+  uint64_t* reach;
+  uint64_t last_word_mask;
+  struct pos start = getStartPosition(aboard);
+  bool changed;
+  size_t i;
+  int y;
+  int w;
+
+  open = malloc(n * sizeof(uint64_t));
+  reach = calloc(n, sizeof(uint64_t));
+  if (open == NULL || reach == NULL) {
+    free(open);
+    free(reach);
+    return RES_FAILED;
+  }
+
+  // Open cells: everything but barriers, cut to the columns of the board
+  last_word_mask = ~(uint64_t) 0 >> (63 - (aboard->last_col & 63));
+  acheck->open_cells = 0;
+  for (y = 0; y < rows; y++) {
+    for (w = 0; w < words; w++) {
+      i = (size_t) y * words + w;
+      open[i] = ~aboard->planes[BP_BLOCKED][i];
+      if (w == words - 1) {
+        open[i] &= last_word_mask;
+      }
+      acheck->open_cells += __builtin_popcountll(open[i]);
+    }
+  }
+
+  // Seed the fill at the start position
+  i = (size_t) start.y * words + (start.x >> 6);
+  reach[i] = open[i] & ((uint64_t) 1 << (start.x & 63));
+  fillRow(reach + (size_t) start.y * words, open + (size_t) start.y * words, words, cols, torus);
+
+  // On a torus board the first and the last row are neighbours, too
+  do {
+    changed = false;
+    for (y = 1; y < rows; y++) {
+      changed |= updateRow(reach, open, words, cols, torus, y, y - 1);
+    }
+    if (torus) {
+      changed |= updateRow(reach, open, words, cols, torus, 0, rows - 1);
+    }
+    for (y = rows - 2; y >= 0; y--) {
+      changed |= updateRow(reach, open, words, cols, torus, y, y + 1);
+    }
+    if (torus) {
+      changed |= updateRow(reach, open, words, cols, torus, rows - 1, 0);
+    }
+  } while (changed);
+
+  // Gather the results
+  acheck->reach = reach;
+  acheck->words_per_row = words;
+  acheck->rows = rows;
+  acheck->reachable_cells = 0;
+  acheck->unreachable_food = 0;
+  acheck->dead_ends = 0;
+  for (y = 0; y < rows; y++) {
+    for (w = 0; w < words; w++) {
+      uint64_t food;
+
+      i = (size_t) y * words + w;
+      acheck->reachable_cells += __builtin_popcountll(reach[i]);
+      food = (aboard->planes[BP_FOOD_1][i] | aboard->planes[BP_FOOD_2][i]
+              | aboard->planes[BP_FOOD_3][i]) & ~reach[i];
+      if (food != 0 && acheck->unreachable_food == 0) {
+        acheck->first_unreachable_food.y = y;
+        acheck->first_unreachable_food.x = (w << 6) + __builtin_ctzll(food);
+      }
+      acheck->unreachable_food += __builtin_popcountll(food);
+    }
+    acheck->dead_ends += countDeadEnds(reach, open, words, y, rows, cols, torus);
+  }
+  free(open);
+  return RES_OK;
+}
+
+// Can the worm get to cell (y,x)?
+bool isReachable(struct level_check* acheck, int y, int x) {
+  return (acheck->reach[(size_t) y * acheck->words_per_row + (x >> 6)] >> (x & 63)) & 1;
+}
+
+void releaseLevelCheck(struct level_check* acheck) {
+  free(acheck->reach);
+  acheck->reach = NULL;
+}
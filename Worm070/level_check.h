@@ -0,0 +1,41 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Validation of levels: which cells can the worm reach from its start?
+//
+// The flood fill works on the bit planes of the board, 64 cells per
+// word operation. Cells held by the worm count as open since the worm
+// moves away from them. On a torus board the fill wraps around the edges.
+
+#ifndef _LEVEL_CHECK_H
+#define _LEVEL_CHECK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "worm.h"
+#include "board_model.h"
+
+// Result of checkLevel()
+struct level_check {
+    uint64_t* reach;   // Reachable cells, laid out like the bit planes of the board
+    int words_per_row; // Same as in the board
+    int rows;          // Number of rows of the board
+
+    int open_cells;        // Cells without barrier
+    int reachable_cells;   // Open cells reachable from the start position
+    int unreachable_food;  // Food items the worm can never eat
+    struct pos first_unreachable_food; // Top-left one of them (if any)
+    int dead_ends;         // Reachable cells with only one open neighbour
+};
+
+extern enum ResCodes checkLevel(struct board* aboard, struct level_check* acheck);
+extern bool isReachable(struct level_check* acheck, int y, int x);
+extern void releaseLevelCheck(struct level_check* acheck);
+
+#endif  // #define _LEVEL_CHECK_H
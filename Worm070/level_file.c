@@ -0,0 +1,274 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Loading levels from text files
+//
+// The file is mapped into memory and parsed in a single pass straight
+// into the board. Only cells that are not free are touched on the board;
+// nothing is displayed here (see renderBoard()).
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "worm.h"
+#include "board_model.h"
+#include "board_planes.h"
+#include "level_file.h"
+#include "level_script.h"
+
+// Meaning of the characters in a level file
+enum LevelSymbols {
+    LS_INVALID,  // Not allowed
+    LS_FREE,
+    LS_START,
+    LS_BARRIER,
+    LS_FOOD_1,
+    LS_FOOD_2,
+    LS_FOOD_3,
+};
+
+static const uint8_t level_symbols[256] = {
+  [' ']                   = LS_FREE,
+  ['.']                   = LS_FREE,
+  [SYMBOL_START_POSITION] = LS_START,
+  [SYMBOL_BARRIER]        = LS_BARRIER,
+  [SYMBOL_FOOD_1]         = LS_FOOD_1,
+  [SYMBOL_FOOD_2]         = LS_FOOD_2,
+  [SYMBOL_FOOD_3]         = LS_FOOD_3,
+};
+
+static const enum BoardCodes code_of_symbol[] = {
+  [LS_BARRIER] = BC_BARRIER,
+  [LS_FOOD_1]  = BC_FOOD_1,
+  [LS_FOOD_2]  = BC_FOOD_2,
+  [LS_FOOD_3]  = BC_FOOD_3,
+};
+
+// Skip blanks and tabs
+static const char* skipBlanks(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t')) {
+    p++;
+  }
+  return p;
+}
+
+// Read the given word followed by a blank or the end of the line
+static bool readWord(const char** ap, const char* end, const char* word) {
+  size_t len = strlen(word);
+  const char* p = *ap;
+
+  if ((size_t) (end - p) < len || memcmp(p, word, len) != 0) {
+    return false;
+  }
+  p += len;
+  if (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+    return false;
+  }
+  *ap = skipBlanks(p, end);
+  return true;
+}
+
+// Read a positive decimal number; returns false if there is none
+// or if it is too large
+static bool readNumber(const char** ap, const char* end, int* value) {
+  const char* p = skipBlanks(*ap, end);
+  long long n = 0;
+
+  if (p == end || *p < '0' || *p > '9') {
+    return false;
+  }
+  while (p < end && *p >= '0' && *p <= '9') {
+    n = n * 10 + (*p - '0');
+    if (n > MAX_NUMBER_OF_CELLS) {
+      return false;
+    }
+    p++;
+  }
+  *ap = p;
+  *value = (int) n;
+  return true;
+}
+
+// Map a level file into memory and read its header
+enum ResCodes openLevelFile(struct level_file* alevel, const char* path) {
+  int fd;
+  struct stat st;
+  void* data;
+  const char* p;
+  const char* end;
+
+  alevel->path = path;
+  alevel->data = NULL;
+  alevel->size = 0;
+  alevel->error[0] = '\0';
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    snprintf(alevel->error, LEVEL_ERROR_LENGTH, "%s: Datei kann nicht gelesen werden", path);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return RES_FAILED;
+  }
+  if (st.st_size == 0) {
+    snprintf(alevel->error, LEVEL_ERROR_LENGTH, "%s: Datei ist leer", path);
+    close(fd);
+    return RES_FAILED;
+  }
+  data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // The mapping stays valid
+  if (data == MAP_FAILED) {
+    snprintf(alevel->error, LEVEL_ERROR_LENGTH, "%s: Datei kann nicht gelesen werden", path);
+    return RES_FAILED;
+  }
+  // We read the file exactly once from front to back
+  madvise(data, st.st_size, MADV_SEQUENTIAL);
+  alevel->data = data;
+  alevel->size = st.st_size;
+
+  // Header: WORM <rows> <cols> [TORUS] [DIAGONAL]
+  p = alevel->data;
+  end = alevel->data + alevel->size;
+  if (alevel->size < strlen(LEVEL_FILE_MAGIC)
+      || memcmp(p, LEVEL_FILE_MAGIC, strlen(LEVEL_FILE_MAGIC)) != 0) {
+    snprintf(alevel->error, LEVEL_ERROR_LENGTH, "%s, Zeile 1: %s erwartet", path, LEVEL_FILE_MAGIC);
+    closeLevelFile(alevel);
+    return RES_FAILED;
+  }
+  p += strlen(LEVEL_FILE_MAGIC);
+  if (!readNumber(&p, end, &alevel->rows) || !readNumber(&p, end, &alevel->cols)
+      || alevel->rows < 1 || alevel->cols < 1
+      || (long long) alevel->rows * alevel->cols > MAX_NUMBER_OF_CELLS) {
+    snprintf(alevel->error, LEVEL_ERROR_LENGTH,
+        "%s, Zeile 1: Zeilen und Spalten fehlen oder sind ungueltig (hoechstens %d Zellen)",
+        path, MAX_NUMBER_OF_CELLS);
+    closeLevelFile(alevel);
+    return RES_FAILED;
+  }
+  p = skipBlanks(p, end);
+  alevel->torus = false;
+  alevel->diagonal = false;
+  while (p < end && *p != '\r' && *p != '\n') {
+    if (readWord(&p, end, LEVEL_FILE_TORUS)) {
+      alevel->torus = true;
+    } else if (readWord(&p, end, LEVEL_FILE_DIAGONAL)) {
+      alevel->diagonal = true;
+    } else {
+      break;
+    }
+  }
+  if (p < end && *p == '\r') {
+    p++;
+  }
+  if (p < end && *p != '\n') {
+    snprintf(alevel->error, LEVEL_ERROR_LENGTH, "%s, Zeile 1: unerwartetes Zeichen '%c'", path, *p);
+    closeLevelFile(alevel);
+    return RES_FAILED;
+  }
+  alevel->body = (p < end) ? p + 1 - alevel->data : alevel->size;
+  return RES_OK;
+}
+
+// Read the rows of cells into the board.
+// The board must have the dimensions given by the header and must be empty.
+enum ResCodes loadLevelFile(struct level_file* alevel, struct board* aboard) {
+  const char* p = alevel->data + alevel->body;
+  const char* end = alevel->data + alevel->size;
+  int y;
+  int x;
+  int line;
+  int symbol;
+  bool have_start = false;
+
+  if (alevel->torus) {
+    setBoardTorus(aboard, true);
+  }
+  if (alevel->diagonal) {
+    setBoardDiagonal(aboard, true);
+  }
+  for (y = 0; y < alevel->rows; y++) {
+    line = y + 2;  // The header is line 1
+    if (p >= end) {
+      snprintf(alevel->error, LEVEL_ERROR_LENGTH,
+          "%s: %d Zeilen erwartet, aber nur %d gefunden", alevel->path, alevel->rows, y);
+      return RES_FAILED;
+    }
+    for (x = 0; p < end && *p != '\n'; p++) {
+      if (*p == '\r' && (p + 1 == end || p[1] == '\n')) {
+        continue;  // Line ends with CR LF
+      }
+      symbol = level_symbols[(unsigned char) *p];
+      if (symbol == LS_INVALID) {
+        snprintf(alevel->error, LEVEL_ERROR_LENGTH,
+            "%s, Zeile %d, Spalte %d: unbekanntes Zeichen '%c'", alevel->path, line, x + 1, *p);
+        return RES_FAILED;
+      }
+      if (x >= alevel->cols) {
+        snprintf(alevel->error, LEVEL_ERROR_LENGTH,
+            "%s, Zeile %d: mehr als %d Spalten", alevel->path, line, alevel->cols);
+        return RES_FAILED;
+      }
+      if (symbol == LS_START) {
+        if (have_start) {
+          snprintf(alevel->error, LEVEL_ERROR_LENGTH,
+              "%s, Zeile %d, Spalte %d: zweite Startposition", alevel->path, line, x + 1);
+          return RES_FAILED;
+        }
+        have_start = true;
+        aboard->start_pos.y = y;
+        aboard->start_pos.x = x;
+      } else if (symbol != LS_FREE) {
+        setCellContent(aboard, y, x, code_of_symbol[symbol]);
+      }
+      x++;
+    }
+    if (p < end) {
+      p++;  // Skip the newline
+    }
+  }
+  // Without '@' the worm starts at the free cell nearest to the default
+  // start position of the board
+  if (!have_start
+      && !findNearestFreeCell(aboard, aboard->start_pos, &aboard->start_pos)) {
+    snprintf(alevel->error, LEVEL_ERROR_LENGTH,
+        "%s: keine freie Zelle fuer den Start", alevel->path);
+    return RES_FAILED;
+  }
+  // Only empty lines and scripts may follow
+  alevel->scripts = alevel->size;
+  for (line = alevel->rows + 2; p < end; p++) {
+    if (*p == '\n') {
+      line++;
+    } else if (*p == LEVEL_SCRIPT_COMMENT
+               || ((size_t) (end - p) >= strlen(LEVEL_SCRIPT_KEYWORD)
+                   && memcmp(p, LEVEL_SCRIPT_KEYWORD, strlen(LEVEL_SCRIPT_KEYWORD)) == 0)) {
+      alevel->scripts = p - alevel->data;
+      alevel->scripts_line = line;
+      break;
+    } else if (*p != ' ' && *p != '\t' && *p != '\r') {
+      snprintf(alevel->error, LEVEL_ERROR_LENGTH,
+          "%s, Zeile %d: mehr als %d Zeilen", alevel->path, line, alevel->rows);
+      return RES_FAILED;
+    }
+  }
+  return RES_OK;
+}
+
+// Release the mapping of the file
+void closeLevelFile(struct level_file* alevel) {
+  if (alevel->data != NULL) {
+    munmap((void*) alevel->data, alevel->size);
+    alevel->data = NULL;
+  }
+}
@@ -0,0 +1,58 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Loading levels from text files
+//
+// Format of a level file:
+//   WORM <rows> <cols> [TORUS] [DIAGONAL]
+//   (TORUS: leaving the board at an edge enters it at the opposite edge;
+//    DIAGONAL: the worm may move diagonally)
+//   followed by <rows> lines of at most <cols> characters each:
+//     ' ' or '.'  free cell (missing characters at the end of a line are free, too)
+//     '#'         barrier
+//     '2' '4' '6' food of type 1, 2 and 3
+//     '@'         start position of the worm (optional; at most once;
+//                 without it the worm starts at the free cell nearest
+//                 to the middle of the left edge)
+//   optionally followed by scripts for moving barriers (see level_script.h)
+
+#ifndef _LEVEL_FILE_H
+#define _LEVEL_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "worm.h"
+#include "board_model.h"
+
+#define LEVEL_FILE_MAGIC "WORM"   // First word of a level file
+#define LEVEL_FILE_TORUS "TORUS"  // Optional words at the end of the header
+#define LEVEL_FILE_DIAGONAL "DIAGONAL"
+#define SYMBOL_START_POSITION '@' // Start position of the worm in a level file
+#define LEVEL_ERROR_LENGTH 160    // Size of buffers for error messages
+
+// A level file mapped into memory
+struct level_file {
+    const char* path;  // Name of the file (for error messages)
+    const char* data;  // Contents of the file
+    size_t size;       // Size of the file in bytes
+    size_t body;       // Offset of the first row of cells in data
+    int rows;          // Dimensions of the board as given by the header
+    int cols;
+    bool torus;        // The header asks for a torus board
+    bool diagonal;     // The header allows diagonal moves
+    size_t scripts;    // Offset of the scripts in data; size if there are none
+    int scripts_line;  // Line number of the scripts
+    char error[LEVEL_ERROR_LENGTH]; // Reason of the last failure
+};
+
+extern enum ResCodes openLevelFile(struct level_file* alevel, const char* path);
+extern enum ResCodes loadLevelFile(struct level_file* alevel, struct board* aboard);
+extern void closeLevelFile(struct level_file* alevel);
+
+#endif  // #define _LEVEL_FILE_H
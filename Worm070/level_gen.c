@@ -0,0 +1,193 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Procedural generation of levels
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "worm.h"
+#include "board_model.h"
+#include "rng.h"
+#include "level_check.h"
+#include "level_gen.h"
+
+// Board cells per generated item: the amount of each item grows with the area
+#define GEN_CELLS_PER_ROOM     700
+#define GEN_CELLS_PER_CORRIDOR 900
+#define GEN_CELLS_PER_WALL     250
+#define GEN_CELLS_PER_FOOD     600  // per food type
+#define GEN_FOOD_ATTEMPTS      100  // Random cells tried for a single food item
+
+// A rectangle of the board
+struct area {
+    int y_min;
+    int x_min;
+    int y_max;
+    int x_max;
+};
+
+// Draw a number from [low, high]
+static int nextRandomBetween(struct rng* arng, int low, int high) {
+  return low + (int) nextRandomBelow(arng, high - low + 1);
+}
+
+static bool isInArea(struct area* aarea, int y, int x) {
+  return y >= aarea->y_min && y <= aarea->y_max
+      && x >= aarea->x_min && x <= aarea->x_max;
+}
+
+// Put a barrier on the cell unless it is off the board or kept clear
+static void putBarrier(struct board* aboard, struct area* clear, int y, int x) {
+  if (y < 0 || y > aboard->last_row || x < 0 || x > aboard->last_col
+      || isInArea(clear, y, x)) {
+    return;
+  }
+  setCellContent(aboard, y, x, BC_BARRIER);
+}
+
+// Remove a barrier (used for the doors of rooms)
+static void putOpening(struct board* aboard, int y, int x) {
+  struct pos position = { y, x };
+
+  if (y < 0 || y > aboard->last_row || x < 0 || x > aboard->last_col) {
+    return;
+  }
+  if (getContentAt(aboard, position) == BC_BARRIER) {
+    setCellContent(aboard, y, x, BC_FREE_CELL);
+  }
+}
+
+// A straight wall from (y,x) with the given length
+static void putWall(struct board* aboard, struct area* clear,
+                    int y, int x, int len, bool horizontal) {
+  int i;
+
+  for (i = 0; i < len; i++) {
+    if (horizontal) {
+      putBarrier(aboard, clear, y, x + i);
+    } else {
+      putBarrier(aboard, clear, y + i, x);
+    }
+  }
+}
+
+// A rectangular room with a door in at least one of its walls
+static void putRoom(struct board* aboard, struct area* clear, struct rng* arng) {
+  int h = nextRandomBetween(arng, 5, 11);
+  int w = nextRandomBetween(arng, 8, 20);
+  int y = nextRandomBetween(arng, 0, aboard->last_row);
+  int x = nextRandomBetween(arng, 0, aboard->last_col);
+  int doors = nextRandomBetween(arng, 1, 15); // One bit per wall
+  int side;
+
+  putWall(aboard, clear, y,         x,         w, true);
+  putWall(aboard, clear, y + h - 1, x,         w, true);
+  putWall(aboard, clear, y,         x,         h, false);
+  putWall(aboard, clear, y,         x + w - 1, h, false);
+
+  // Doors are two cells wide and never in a corner
+  for (side = 0; side < 4; side++) {
+    int along;
+
+    if ((doors & (1 << side)) == 0) {
+      continue;
+    }
+    if (side < 2) {
+      along = x + nextRandomBetween(arng, 1, w - 3);
+      putOpening(aboard, side == 0 ? y : y + h - 1, along);
+      putOpening(aboard, side == 0 ? y : y + h - 1, along + 1);
+    } else {
+      along = y + nextRandomBetween(arng, 1, h - 3);
+      putOpening(aboard, along,     side == 2 ? x : x + w - 1);
+      putOpening(aboard, along + 1, side == 2 ? x : x + w - 1);
+    }
+  }
+}
+
+// A corridor: two parallel walls with a gap of two or three cells
+static void putCorridor(struct board* aboard, struct area* clear, struct rng* arng) {
+  bool horizontal = nextRandomBelow(arng, 2) == 0;
+  int len = nextRandomBetween(arng, 10, 30);
+  int gap = nextRandomBetween(arng, 3, 4);
+  int y = nextRandomBetween(arng, 0, aboard->last_row);
+  int x = nextRandomBetween(arng, 0, aboard->last_col);
+
+  putWall(aboard, clear, y, x, len, horizontal);
+  if (horizontal) {
+    putWall(aboard, clear, y + gap, x, len, true);
+  } else {
+    putWall(aboard, clear, y, x + gap, len, false);
+  }
+}
+
+// Generate a level on a board just set up by initializeBoard().
+// Only the random numbers drawn from the seed decide about the layout.
+// The order of all draws is fixed; do not reorder them, otherwise
+// the levels of existing seeds change.
+void generateLevel(struct board* aboard, uint64_t seed) {
+  struct rng gen_rng;
+  struct area clear;  // Kept free around the start position
+  struct pos position;
+  struct level_check check; // Cells the worm can reach
+  bool checked;
+  int attempts;
+  long long cells = (long long) (aboard->last_row + 1) * (aboard->last_col + 1);
+  long long n;
+  int t;
+
+  seedRng(&gen_rng, seed);
+
+  // The start position and the cells in front of the worm
+  aboard->start_pos.y = nextRandomBetween(&gen_rng, 0, aboard->last_row);
+  aboard->start_pos.x = nextRandomBetween(&gen_rng, 0,
+      aboard->last_col > GEN_START_CLEARANCE ? aboard->last_col - GEN_START_CLEARANCE : 0);
+  clear.y_min = aboard->start_pos.y - 1;
+  clear.y_max = aboard->start_pos.y + 1;
+  clear.x_min = aboard->start_pos.x - 1;
+  clear.x_max = aboard->start_pos.x + GEN_START_CLEARANCE;
+
+  for (n = cells / GEN_CELLS_PER_ROOM + 1; n > 0; n--) {
+    putRoom(aboard, &clear, &gen_rng);
+  }
+  for (n = cells / GEN_CELLS_PER_CORRIDOR + 1; n > 0; n--) {
+    putCorridor(aboard, &clear, &gen_rng);
+  }
+  for (n = cells / GEN_CELLS_PER_WALL + 1; n > 0; n--) {
+    bool horizontal = nextRandomBelow(&gen_rng, 2) == 0;
+    int len = nextRandomBetween(&gen_rng, 2, 7);
+    int y = nextRandomBetween(&gen_rng, 0, aboard->last_row);
+    int x = nextRandomBetween(&gen_rng, 0, aboard->last_col);
+
+    putWall(aboard, &clear, y, x, len, horizontal);
+  }
+
+  // Food of each type at random free cells outside of the start area
+  // that the worm can reach. Cells walled off are skipped; if the check
+  // runs out of memory, food may end up there.
+  // The free cell set of the board is kept in the same order for every
+  // cell layout, hence the picked cells do not depend on the layout.
+  checked = checkLevel(aboard, &check) == RES_OK;
+  for (t = 0; t < NUMBER_OF_FOOD_TYPES; t++) {
+    for (n = cells / GEN_CELLS_PER_FOOD + 1; n > 0; n--) {
+      for (attempts = 0; attempts < GEN_FOOD_ATTEMPTS; attempts++) {
+        if (!pickRandomFreeCell(aboard, &gen_rng, &position)) {
+          break;
+        }
+        if (!isInArea(&clear, position.y, position.x)
+            && (!checked || isReachable(&check, position.y, position.x))) {
+          setCellContent(aboard, position.y, position.x, BC_FOOD_1 + t);
+          break;
+        }
+      }
+    }
+  }
+  if (checked) {
+    releaseLevelCheck(&check);
+  }
+}
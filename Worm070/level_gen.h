@@ -0,0 +1,29 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Procedural generation of levels
+//
+// A level is made of rooms, corridors and scattered walls plus food.
+// Everything is drawn from a generator seeded with the given seed only,
+// so equal seeds and board sizes give equal levels on every machine.
+
+#ifndef _LEVEL_GEN_H
+#define _LEVEL_GEN_H
+
+#include <stdint.h>
+#include "worm.h"
+#include "board_model.h"
+
+// Free space kept right of the start position so that the worm
+// can always make its first moves
+#define GEN_START_CLEARANCE 8
+
+extern void generateLevel(struct board* aboard, uint64_t seed);
+
+#endif  // #define _LEVEL_GEN_H
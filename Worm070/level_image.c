@@ -0,0 +1,312 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Precompiled binary level files (level images)
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "worm.h"
+#include "board_model.h"
+#include "board_planes.h"
+#include "level_image.h"
+
+// The cell layout of this build
+#ifdef BOARD_LAYOUT_TILED
+#define LEVEL_IMAGE_TILED 1
+#else
+#define LEVEL_IMAGE_TILED 0
+#endif
+
+// Does the file start like a level image?
+bool isLevelImage(const char* path) {
+  char magic[sizeof(((struct level_image_header*) 0)->magic)];
+  int fd = open(path, O_RDONLY);
+  bool res;
+
+  if (fd < 0) {
+    return false;
+  }
+  res = read(fd, magic, sizeof(magic)) == sizeof(magic)
+        && memcmp(magic, LEVEL_IMAGE_MAGIC, sizeof(magic)) == 0;
+  close(fd);
+  return res;
+}
+
+// Content hash of a board storage block (FNV-1a over 64-bit words).
+// The size of a storage block is always a multiple of 8.
+uint64_t hashLevelImage(const void* data, size_t size) {
+  const uint64_t* words = data;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  size_t i;
+
+  for (i = 0; i < size / sizeof(uint64_t); i++) {
+    hash ^= words[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// Is the cell (y,x) of the image one a level may hold: the default type
+// of free, food or barrier inside the board, out of bounds on the ring?
+static bool isValidImageCell(uint8_t cell, bool inside) {
+  enum BoardCodes code = cell & BC_CODE_MASK;
+
+  if (!inside) {
+    return cell == BOARD_CELL(BC_OUT_OF_BOUNDS);
+  }
+  return cell == BOARD_CELL(code)
+      && (code == BC_FREE_CELL || isFoodCode(code) || code == BC_BARRIER);
+}
+
+// Does the board storage agree with itself and with the header?
+// The board trusts everything in the image: the ring of out of bounds
+// cells, the bit planes, the set of free cells, the food counters and the
+// start cell. So all of them are checked against the cells.
+static bool isImageBoardConsistent(struct board* aboard, struct level_image_header* header) {
+  uint64_t expected[BP_NUMBER_OF_PLANES];
+  int food_of_type[NUMBER_OF_FOOD_TYPES] = { 0 };
+  int free_cells = 0;
+  int index;
+  int slot;
+  int y;
+  int x;
+  int p;
+  uint8_t cell;
+  enum BoardCodes code;
+  bool inside;
+
+  // All cells of the ring rows and of the stored rows, row by row
+  for (y = -1; y <= aboard->last_row + 1; y++) {
+    for (p = 0; p < BP_NUMBER_OF_PLANES; p++) {
+      expected[p] = 0;
+    }
+    for (x = -1; x < aboard->stride - 1; x++) {
+      index = getCellIndex(aboard, y, x);
+      cell = *getCell(aboard, index);
+      code = cell & BC_CODE_MASK;
+      inside = y >= 0 && y <= aboard->last_row && x >= 0 && x <= aboard->last_col;
+      if (!isValidImageCell(cell, inside)) {
+        return false;
+      }
+      // A free cell and only a free cell has a slot pointing back at it
+      slot = aboard->free_slot[index];
+      if (inside && code == BC_FREE_CELL) {
+        if (slot < 0 || slot >= header->free_count || aboard->free_cells[slot] != index) {
+          return false;
+        }
+        free_cells++;
+      } else if (slot != -1) {
+        return false;
+      }
+      if (!inside) {
+        continue;
+      }
+      if (isFoodCode(code)) {
+        food_of_type[code - BC_FOOD_1]++;
+      }
+      // Compare the planes a word at a time
+      for (p = 0; p < BP_NUMBER_OF_PLANES; p++) {
+        if (getPlanesOfCode(code) & (1 << p)) {
+          expected[p] |= (uint64_t) 1 << (x & 63);
+        }
+      }
+      if ((x & 63) == 63 || x == aboard->last_col) {
+        for (p = 0; p < BP_NUMBER_OF_PLANES; p++) {
+          if (aboard->planes[p][(size_t) y * aboard->words_per_row + (x >> 6)] != expected[p]) {
+            return false;
+          }
+          expected[p] = 0;
+        }
+      }
+    }
+  }
+  // With each free cell in a slot of its own, all slots are taken
+  if (free_cells != header->free_count
+      || food_of_type[0] + food_of_type[1] + food_of_type[2] != header->food_items) {
+    return false;
+  }
+  for (p = 0; p < NUMBER_OF_FOOD_TYPES; p++) {
+    if (food_of_type[p] != header->food_items_of_type[p]) {
+      return false;
+    }
+  }
+  return getContentOfCell(aboard, getCellIndex(aboard, header->start_y, header->start_x))
+      == BC_FREE_CELL;
+}
+
+// Check the board storage of a mapped image before a board uses it.
+// The hash only catches damage: anybody can compute it for a patched image.
+static enum ResCodes checkLevelImageStorage(struct level_image* aimage,
+                                           struct level_image_header* header) {
+  char* storage = aimage->map + LEVEL_IMAGE_OFFSET;
+  struct board probe;
+
+  if (hashLevelImage(storage, header->image_size) != header->hash) {
+    snprintf(aimage->error, LEVEL_ERROR_LENGTH,
+        "%s: Pruefsumme des Level-Abbilds stimmt nicht", aimage->path);
+    return RES_FAILED;
+  }
+  // Only lays out the arrays; nothing is read or written
+  attachBoardStorage(&probe, header->rows, header->cols, storage);
+  if (!isImageBoardConsistent(&probe, header)) {
+    snprintf(aimage->error, LEVEL_ERROR_LENGTH, "%s: Level-Abbild ist beschaedigt", aimage->path);
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
+
+// Map a level image and check its header and its board storage.
+// The dimensions of the board are returned in *arows and *acols.
+enum ResCodes openLevelImage(struct level_image* aimage, const char* path, int* arows, int* acols) {
+  int fd;
+  struct stat st;
+  void* map;
+  struct level_image_header* header;
+
+  aimage->path = path;
+  aimage->map = NULL;
+  aimage->map_size = 0;
+  aimage->error[0] = '\0';
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    snprintf(aimage->error, LEVEL_ERROR_LENGTH, "%s: Datei kann nicht gelesen werden", path);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return RES_FAILED;
+  }
+  if (st.st_size < LEVEL_IMAGE_OFFSET) {
+    snprintf(aimage->error, LEVEL_ERROR_LENGTH, "%s: Datei ist zu kurz", path);
+    close(fd);
+    return RES_FAILED;
+  }
+  // A private writable mapping: the board may change its cells during the
+  // game; the kernel copies only the pages written to. The file stays as it is.
+  map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);  // The mapping stays valid
+  if (map == MAP_FAILED) {
+    snprintf(aimage->error, LEVEL_ERROR_LENGTH, "%s: Datei kann nicht gelesen werden", path);
+    return RES_FAILED;
+  }
+  aimage->map = map;
+  aimage->map_size = st.st_size;
+
+  // Check the header
+  header = map;
+  if (memcmp(header->magic, LEVEL_IMAGE_MAGIC, sizeof(header->magic)) != 0
+      || header->version != LEVEL_IMAGE_VERSION) {
+    snprintf(aimage->error, LEVEL_ERROR_LENGTH, "%s: kein Level-Abbild der Version %d",
+        path, LEVEL_IMAGE_VERSION);
+    closeLevelImage(aimage);
+    return RES_FAILED;
+  }
+  if (header->tiled != LEVEL_IMAGE_TILED) {
+    snprintf(aimage->error, LEVEL_ERROR_LENGTH,
+        "%s: Level-Abbild passt nicht zur Anordnung der Zellen dieses Programms", path);
+    closeLevelImage(aimage);
+    return RES_FAILED;
+  }
+  if (header->rows < 1 || header->cols < 1
+      || (long long) header->rows * header->cols > MAX_NUMBER_OF_CELLS
+      || header->image_size != getBoardStorageSize(header->rows, header->cols)
+      || header->image_size > aimage->map_size - LEVEL_IMAGE_OFFSET
+      || header->start_y < 0 || header->start_y >= header->rows
+      || header->start_x < 0 || header->start_x >= header->cols
+      || header->free_count < 0 || header->free_count > header->rows * header->cols) {
+    snprintf(aimage->error, LEVEL_ERROR_LENGTH, "%s: Level-Abbild ist beschaedigt", path);
+    closeLevelImage(aimage);
+    return RES_FAILED;
+  }
+  if (checkLevelImageStorage(aimage, header) != RES_OK) {
+    closeLevelImage(aimage);
+    return RES_FAILED;
+  }
+  *arows = header->rows;
+  *acols = header->cols;
+  return RES_OK;
+}
+
+// Let the board use the storage in the mapped image (zero-copy).
+// The image must have passed openLevelImage().
+void attachLevelImage(struct level_image* aimage, struct board* aboard) {
+  struct level_image_header* header = (struct level_image_header*) aimage->map;
+  int t;
+
+  attachBoardStorage(aboard, header->rows, header->cols, aimage->map + LEVEL_IMAGE_OFFSET);
+  aboard->start_pos.y = header->start_y;
+  aboard->start_pos.x = header->start_x;
+  setBoardTorus(aboard, header->torus != 0);
+  setBoardDiagonal(aboard, header->diagonal != 0);
+  aboard->food_items = header->food_items;
+  for (t = 0; t < NUMBER_OF_FOOD_TYPES; t++) {
+    aboard->food_items_of_type[t] = header->food_items_of_type[t];
+  }
+  aboard->free_count = header->free_count;
+}
+
+// Release the mapping.
+// A board attached to the image must not be used afterwards.
+void closeLevelImage(struct level_image* aimage) {
+  if (aimage->map != NULL) {
+    munmap(aimage->map, aimage->map_size);
+    aimage->map = NULL;
+  }
+}
+
+// Write the board as level image.
+// The content hash of the image is returned in *ahash.
+// On failure a message is left in error (LEVEL_ERROR_LENGTH characters).
+enum ResCodes writeLevelImage(struct board* aboard, const char* path,
+                              uint64_t* ahash, char* error) {
+  char page[LEVEL_IMAGE_OFFSET];  // Header padded to a full page
+  struct level_image_header* header = (struct level_image_header*) page;
+  FILE* f;
+  int t;
+  bool ok;
+
+  memset(page, 0, sizeof(page));
+  memcpy(header->magic, LEVEL_IMAGE_MAGIC, sizeof(header->magic));
+  header->version = LEVEL_IMAGE_VERSION;
+  header->tiled = LEVEL_IMAGE_TILED;
+  header->torus = isBoardTorus(aboard);
+  header->diagonal = isBoardDiagonal(aboard);
+  header->rows = aboard->last_row + 1;
+  header->cols = aboard->last_col + 1;
+  header->start_y = aboard->start_pos.y;
+  header->start_x = aboard->start_pos.x;
+  header->food_items = aboard->food_items;
+  for (t = 0; t < NUMBER_OF_FOOD_TYPES; t++) {
+    header->food_items_of_type[t] = aboard->food_items_of_type[t];
+  }
+  header->free_count = aboard->free_count;
+  header->image_size = aboard->storage_size;
+  header->hash = hashLevelImage(aboard->storage, aboard->storage_size);
+
+  f = fopen(path, "wb");
+  if (f == NULL) {
+    snprintf(error, LEVEL_ERROR_LENGTH, "%s: Datei kann nicht geschrieben werden", path);
+    return RES_FAILED;
+  }
+  ok = fwrite(page, sizeof(page), 1, f) == 1
+       && fwrite(aboard->storage, aboard->storage_size, 1, f) == 1;
+  ok = (fclose(f) == 0) && ok;
+  if (!ok) {
+    snprintf(error, LEVEL_ERROR_LENGTH, "%s: Fehler beim Schreiben", path);
+    return RES_FAILED;
+  }
+  *ahash = header->hash;
+  return RES_OK;
+}
@@ -0,0 +1,72 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Precompiled binary level files (level images)
+//
+// A level image holds the complete storage block of a board (packed cells,
+// bit planes, set of free cells; see layoutBoardStorage()) behind a header
+// of one page. The file is mapped into memory and the board uses the
+// mapping in place. Pages are only copied when the game writes to them.
+//
+// Images are written in the byte order of the machine and depend on the
+// cell layout of the build (BOARD_LAYOUT_TILED); both are checked on load.
+// So are the content hash and the board itself: the ring of out of bounds
+// cells, the bit planes, the set of free cells, the food counters and the
+// start cell must agree with the cells. The board trusts them once attached.
+
+#ifndef _LEVEL_IMAGE_H
+#define _LEVEL_IMAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "worm.h"
+#include "board_model.h"
+#include "level_file.h"
+
+#define LEVEL_IMAGE_MAGIC "WORMIMG1"   // First 8 bytes of a level image
+#define LEVEL_IMAGE_VERSION 3
+#define LEVEL_IMAGE_OFFSET 4096        // Offset of the board storage in the file
+
+// Header at the start of a level image
+struct level_image_header {
+    char magic[8];        // LEVEL_IMAGE_MAGIC
+    uint32_t version;     // LEVEL_IMAGE_VERSION
+    uint32_t tiled;       // 1 if the cells are stored in tiles
+    uint32_t torus;       // 1 for a torus board
+    uint32_t diagonal;    // 1 if diagonal moves are allowed
+    int32_t rows;         // Dimensions of the board
+    int32_t cols;
+    int32_t start_y;      // Start position of the worm
+    int32_t start_x;
+    int32_t food_items;   // Food counters of the board
+    int32_t food_items_of_type[NUMBER_OF_FOOD_TYPES];
+    int32_t free_count;   // Number of free cells
+    uint64_t image_size;  // Size of the board storage in bytes
+    uint64_t hash;        // Content hash of the board storage
+};
+
+// A mapped level image
+struct level_image {
+    const char* path;  // Name of the file (for error messages)
+    char* map;         // Mapping of the whole file
+    size_t map_size;
+    char error[LEVEL_ERROR_LENGTH]; // Reason of the last failure
+};
+
+extern bool isLevelImage(const char* path);
+extern enum ResCodes openLevelImage(struct level_image* aimage, const char* path, int* arows, int* acols);
+extern void attachLevelImage(struct level_image* aimage, struct board* aboard);
+extern void closeLevelImage(struct level_image* aimage);
+
+extern uint64_t hashLevelImage(const void* data, size_t size);
+extern enum ResCodes writeLevelImage(struct board* aboard, const char* path,
+                                     uint64_t* ahash, char* error);
+
+#endif  // #define _LEVEL_IMAGE_H
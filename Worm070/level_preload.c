@@ -0,0 +1,113 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Loading the next level in the background
+
+#include <curses.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "worm.h"
+#include "board_model.h"
+#include "level.h"
+#include "level_check.h"
+#include "level_preload.h"
+
+// Food the worm cannot get to would keep the level from ever being
+// finished; take it off the board.
+// Only the words of the food planes with food outside the reach plane
+// are looked at, cell by cell.
+static int removeUnreachableFood(struct board* aboard) {
+  struct level_check check;
+  size_t words = (size_t) (aboard->last_row + 1) * aboard->words_per_row;
+  size_t i;
+  uint64_t bits;
+  int removed = 0;
+  int y;
+  int x;
+
+  if (checkLevel(aboard, &check) != RES_OK) {
+    return 0;
+  }
+  for (i = 0; i < words && removed < check.unreachable_food; i++) {
+    bits = (aboard->planes[BP_FOOD_1][i] | aboard->planes[BP_FOOD_2][i]
+            | aboard->planes[BP_FOOD_3][i]) & ~check.reach[i];
+    for (; bits != 0; bits &= bits - 1) {
+      y = i / aboard->words_per_row;
+      x = (i % aboard->words_per_row) * 64 + __builtin_ctzll(bits);
+      setCellContent(aboard, y, x, BC_FREE_CELL);
+      removed++;
+    }
+  }
+  releaseLevelCheck(&check);
+  return removed;
+}
+
+// Set up, check and render the level.
+// Runs in the background thread; it must not call curses.
+static void* loadLevel(void* apreload) {
+  struct level_preload* preload = apreload;
+
+  preload->screen = NULL;
+  preload->removed_food = 0;
+  preload->res_code = setupLevel(&preload->level, &preload->settings);
+  if (preload->res_code != RES_OK) {
+    return NULL;
+  }
+  // Moving barriers change what can be reached; leave such levels alone
+  if (preload->level.scripts.number_of_objects == 0) {
+    preload->removed_food = removeUnreachableFood(&preload->level.board);
+  }
+
+  getScreenSize(&preload->level.board, preload->window_rows, preload->window_cols,
+      &preload->screen_rows, &preload->screen_cols);
+  // One more row for the separator line
+  preload->screen = malloc((size_t) (preload->screen_rows + 1) * preload->screen_cols
+      * sizeof(chtype));
+  if (preload->screen == NULL) {
+    strcpy(preload->level.error, "Kein Speicher fuer die Anzeige des Levels");
+    releaseLevel(&preload->level);
+    preload->res_code = RES_FAILED;
+    return NULL;
+  }
+  prerenderBoard(&preload->level.board, preload->screen,
+      preload->screen_rows, preload->screen_cols);
+  return NULL;
+}
+
+// Start loading the level given by asettings.
+// If no thread can be started, the level is loaded right away.
+// The settings are copied; the strings they refer to must stay valid.
+void startPreload(struct level_preload* apreload, struct game_settings* asettings,
+                  int window_rows, int window_cols) {
+  apreload->settings = *asettings;
+  apreload->window_rows = window_rows;
+  apreload->window_cols = window_cols;
+  apreload->in_background =
+      pthread_create(&apreload->thread, NULL, loadLevel, apreload) == 0;
+  if (!apreload->in_background) {
+    loadLevel(apreload);
+  }
+}
+
+// Wait for the level started by startPreload().
+// On success the caller owns apreload->level and must release it by
+// releaseLevel(); the screen is released by releasePreloadScreen().
+enum ResCodes finishPreload(struct level_preload* apreload) {
+  if (apreload->in_background) {
+    pthread_join(apreload->thread, NULL);
+    apreload->in_background = false;
+  }
+  return apreload->res_code;
+}
+
+void releasePreloadScreen(struct level_preload* apreload) {
+  free(apreload->screen);
+  apreload->screen = NULL;
+}
@@ -0,0 +1,48 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Loading the next level in the background
+//
+// While a level is played, a thread sets up the next one, checks it and
+// renders its board into a buffer. Starting the next level then only
+// copies the buffer to the display.
+
+#ifndef _LEVEL_PRELOAD_H
+#define _LEVEL_PRELOAD_H
+
+#include <curses.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include "worm.h"
+#include "level.h"
+
+struct level_preload {
+    pthread_t thread;
+    bool in_background;  // Has a thread been started for the level?
+
+    // Given by startPreload()
+    struct game_settings settings; // Which level to load
+    int window_rows;     // Rows of the display available for the board
+    int window_cols;     // Columns of the display
+
+    // Results, valid after finishPreload()
+    enum ResCodes res_code;
+    struct level level;  // The level; its error message if res_code != RES_OK
+    chtype* screen;      // The visible part of the board (see prerenderBoard())
+    int screen_rows;
+    int screen_cols;
+    int removed_food;    // Food items removed since the worm cannot reach them
+};
+
+extern void startPreload(struct level_preload* apreload, struct game_settings* asettings,
+                         int window_rows, int window_cols);
+extern enum ResCodes finishPreload(struct level_preload* apreload);
+extern void releasePreloadScreen(struct level_preload* apreload);
+
+#endif  // #define _LEVEL_PRELOAD_H
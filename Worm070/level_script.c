@@ -0,0 +1,521 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Moving barriers driven by small scripts
+//
+// The scripts are compiled in two passes over the text: the first one
+// checks them and sums up the sizes, the second one fills a single block
+// of memory. Running them never allocates.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "worm.h"
+#include "board_model.h"
+#include "level_file.h"
+#include "level_script.h"
+
+// Bytecode: one byte opcode, followed by the operands
+enum ScriptOps {
+    OP_END,     // -
+    OP_WAIT,    // uint16 ticks
+    OP_MOVE,    // int8 dy, int8 dx
+    OP_HIDE,    // -
+    OP_SHOW,    // -
+    OP_REPEAT,  // uint16 count
+    OP_NEXT,    // uint16 offset of the first instruction of the loop
+};
+
+// Size of each instruction in bytes
+static const uint8_t op_sizes[] = {
+  [OP_END]    = 1,
+  [OP_WAIT]   = 3,
+  [OP_MOVE]   = 3,
+  [OP_HIDE]   = 1,
+  [OP_SHOW]   = 1,
+  [OP_REPEAT] = 3,
+  [OP_NEXT]   = 3,
+};
+
+#define SCRIPT_MAX_CODE_SIZE 65536   // Loop offsets are 16 bit
+#define SCRIPT_MAX_STEP 127          // Largest distance of a single MOVE
+#define SCRIPT_WORD_LENGTH 16
+
+// State of the compiler
+struct script_compiler {
+    struct level_scripts* scripts;
+    struct board* board;
+    const char* p;     // Next character of the text
+    const char* end;
+    int line;          // Line number of p in the level file
+    const char* path;
+    char* error;
+    bool emit;         // Second pass: write bytecode and place the objects
+    size_t code_size;
+    int number_of_objects;
+    size_t max_changed;
+    int loop_depth;
+    uint16_t loop_start[SCRIPT_MAX_LOOP_DEPTH];
+};
+
+// ************************************
+// Compiling
+// ************************************
+
+static void skipBlanks(struct script_compiler* acomp) {
+  while (acomp->p < acomp->end && (*acomp->p == ' ' || *acomp->p == '\t' || *acomp->p == '\r')) {
+    acomp->p++;
+  }
+}
+
+// Is the rest of the line empty or a comment?
+static bool atEndOfLine(struct script_compiler* acomp) {
+  skipBlanks(acomp);
+  return acomp->p == acomp->end || *acomp->p == '\n' || *acomp->p == LEVEL_SCRIPT_COMMENT;
+}
+
+static void skipLine(struct script_compiler* acomp) {
+  while (acomp->p < acomp->end && *acomp->p != '\n') {
+    acomp->p++;
+  }
+  if (acomp->p < acomp->end) {
+    acomp->p++;
+  }
+  acomp->line++;
+}
+
+static enum ResCodes fail(struct script_compiler* acomp, const char* message) {
+  snprintf(acomp->error, LEVEL_ERROR_LENGTH, "%s, Zeile %d: %s", acomp->path, acomp->line, message);
+  return RES_FAILED;
+}
+
+// Read a keyword of upper case letters
+static bool readKeyword(struct script_compiler* acomp, char* word) {
+  int len = 0;
+
+  skipBlanks(acomp);
+  while (acomp->p < acomp->end && *acomp->p >= 'A' && *acomp->p <= 'Z'
+         && len < SCRIPT_WORD_LENGTH - 1) {
+    word[len++] = *acomp->p++;
+  }
+  word[len] = '\0';
+  return len > 0;
+}
+
+// Read a decimal number with optional sign within [low, high]
+static bool readInteger(struct script_compiler* acomp, int low, int high, int* avalue) {
+  long value = 0;
+  bool negative = false;
+  bool digits = false;
+
+  skipBlanks(acomp);
+  if (acomp->p < acomp->end && (*acomp->p == '-' || *acomp->p == '+')) {
+    negative = *acomp->p == '-';
+    acomp->p++;
+  }
+  while (acomp->p < acomp->end && *acomp->p >= '0' && *acomp->p <= '9') {
+    value = value * 10 + (*acomp->p++ - '0');
+    digits = true;
+    if (value > MAX_NUMBER_OF_CELLS) {
+      return false;
+    }
+  }
+  if (negative) {
+    value = -value;
+  }
+  if (!digits || value < low || value > high) {
+    return false;
+  }
+  *avalue = value;
+  return true;
+}
+
+static void emitByte(struct script_compiler* acomp, uint8_t byte) {
+  if (acomp->emit) {
+    acomp->scripts->code[acomp->code_size] = byte;
+  }
+  acomp->code_size++;
+}
+
+static void emitOp(struct script_compiler* acomp, enum ScriptOps op, int operand) {
+  emitByte(acomp, op);
+  if (op_sizes[op] == 3) {
+    emitByte(acomp, operand & 0xff);
+    emitByte(acomp, (operand >> 8) & 0xff);
+  }
+}
+
+// Start a new object: SCRIPT <y> <x> <height> <width>
+static enum ResCodes compileObject(struct script_compiler* acomp) {
+  struct board* aboard = acomp->board;
+  struct script_object* object;
+  int y;
+  int x;
+  int height;
+  int width;
+  int i;
+  int j;
+  struct pos position;
+
+  if (!readInteger(acomp, 0, aboard->last_row, &y)
+      || !readInteger(acomp, 0, aboard->last_col, &x)
+      || !readInteger(acomp, 1, aboard->last_row + 1 - y, &height)
+      || !readInteger(acomp, 1, aboard->last_col + 1 - x, &width)) {
+    return fail(acomp, "SCRIPT <Zeile> <Spalte> <Hoehe> <Breite> innerhalb des Spielfelds erwartet");
+  }
+  if (acomp->emit) {
+    object = &acomp->scripts->objects[acomp->number_of_objects];
+    object->y = y;
+    object->x = x;
+    object->height = height;
+    object->width = width;
+    object->shown = true;
+    object->pc = acomp->code_size;
+    object->wait = 0;
+    object->loop_depth = 0;
+    // The object starts as barriers on free cells
+    for (i = y; i < y + height; i++) {
+      for (j = x; j < x + width; j++) {
+        position.y = i;
+        position.x = j;
+        if (getContentAt(aboard, position) != BC_FREE_CELL) {
+          return fail(acomp, "das Objekt ueberdeckt eine belegte Zelle");
+        }
+        setCellContent(aboard, i, j, BC_BARRIER);
+      }
+    }
+  }
+  acomp->number_of_objects++;
+  // A step changes at most all old and all new cells
+  acomp->max_changed += (size_t) 2 * height * width;
+  return RES_OK;
+}
+
+// Compile one instruction of the current object.
+// Sets *adone at the END of the script.
+static enum ResCodes compileInstruction(struct script_compiler* acomp, const char* word, bool* adone) {
+  int a;
+  int b;
+
+  *adone = false;
+  if (strcmp(word, "MOVE") == 0) {
+    if (!readInteger(acomp, -SCRIPT_MAX_STEP, SCRIPT_MAX_STEP, &a)
+        || !readInteger(acomp, -SCRIPT_MAX_STEP, SCRIPT_MAX_STEP, &b)) {
+      return fail(acomp, "MOVE <dy> <dx> erwartet");
+    }
+    emitByte(acomp, OP_MOVE);
+    emitByte(acomp, (uint8_t) (int8_t) a);
+    emitByte(acomp, (uint8_t) (int8_t) b);
+  } else if (strcmp(word, "WAIT") == 0) {
+    if (!readInteger(acomp, 1, UINT16_MAX, &a)) {
+      return fail(acomp, "WAIT <Zuege> erwartet");
+    }
+    emitOp(acomp, OP_WAIT, a);
+  } else if (strcmp(word, "HIDE") == 0) {
+    emitOp(acomp, OP_HIDE, 0);
+  } else if (strcmp(word, "SHOW") == 0) {
+    emitOp(acomp, OP_SHOW, 0);
+  } else if (strcmp(word, "REPEAT") == 0) {
+    if (!readInteger(acomp, 0, UINT16_MAX, &a)) {
+      return fail(acomp, "REPEAT <Anzahl> erwartet");
+    }
+    if (acomp->loop_depth == SCRIPT_MAX_LOOP_DEPTH) {
+      return fail(acomp, "zu viele geschachtelte REPEAT");
+    }
+    emitOp(acomp, OP_REPEAT, a);
+    acomp->loop_start[acomp->loop_depth++] = acomp->code_size;
+  } else if (strcmp(word, "NEXT") == 0) {
+    if (acomp->loop_depth == 0) {
+      return fail(acomp, "NEXT ohne REPEAT");
+    }
+    emitOp(acomp, OP_NEXT, acomp->loop_start[--acomp->loop_depth]);
+  } else if (strcmp(word, "END") == 0) {
+    if (acomp->loop_depth != 0) {
+      return fail(acomp, "REPEAT ohne NEXT");
+    }
+    emitOp(acomp, OP_END, 0);
+    *adone = true;
+  } else {
+    return fail(acomp, "unbekannter Befehl");
+  }
+  if (acomp->code_size > SCRIPT_MAX_CODE_SIZE - 3) {
+    return fail(acomp, "die Skripte sind zu lang");
+  }
+  return RES_OK;
+}
+
+// One pass over all scripts
+static enum ResCodes compilePass(struct script_compiler* acomp) {
+  char word[SCRIPT_WORD_LENGTH];
+  bool in_script = false;
+  bool done;
+
+  while (acomp->p < acomp->end) {
+    if (atEndOfLine(acomp)) {
+      skipLine(acomp);
+      continue;
+    }
+    if (!readKeyword(acomp, word)) {
+      return fail(acomp, "Befehl erwartet");
+    }
+    if (!in_script) {
+      if (strcmp(word, LEVEL_SCRIPT_KEYWORD) != 0) {
+        return fail(acomp, LEVEL_SCRIPT_KEYWORD " erwartet");
+      }
+      if (compileObject(acomp) != RES_OK) {
+        return RES_FAILED;
+      }
+      in_script = true;
+    } else {
+      if (compileInstruction(acomp, word, &done) != RES_OK) {
+        return RES_FAILED;
+      }
+      in_script = !done;
+    }
+    if (!atEndOfLine(acomp)) {
+      return fail(acomp, "unerwartetes Zeichen am Zeilenende");
+    }
+    skipLine(acomp);
+  }
+  if (in_script) {
+    return fail(acomp, "END fehlt");
+  }
+  return RES_OK;
+}
+
+// A level without scripts
+void initializeLevelScripts(struct level_scripts* ascripts) {
+  memset(ascripts, 0, sizeof(*ascripts));
+}
+
+// Compile the scripts in text (up to end) and put their objects onto
+// the board. first_line is the line number of text in the level file.
+// On failure a message is left in error (LEVEL_ERROR_LENGTH bytes).
+enum ResCodes compileLevelScripts(struct level_scripts* ascripts, struct board* aboard,
+                                  const char* text, const char* end, int first_line,
+                                  const char* path, char* error) {
+  struct script_compiler comp;
+  size_t objects_offset;
+  size_t changed_offset;
+  size_t size;
+
+  initializeLevelScripts(ascripts);
+  memset(&comp, 0, sizeof(comp));
+  comp.scripts = ascripts;
+  comp.board = aboard;
+  comp.p = text;
+  comp.end = end;
+  comp.line = first_line;
+  comp.path = path;
+  comp.error = error;
+
+  // First pass: check and measure
+  if (compilePass(&comp) != RES_OK) {
+    return RES_FAILED;
+  }
+  if (comp.number_of_objects == 0) {
+    return RES_OK;
+  }
+
+  // One block: objects, changed cells, bytecode
+  objects_offset = 0;
+  changed_offset = objects_offset + comp.number_of_objects * sizeof(struct script_object);
+  size = changed_offset + comp.max_changed * sizeof(int) + comp.code_size;
+  ascripts->storage = malloc(size);
+  if (ascripts->storage == NULL) {
+    snprintf(error, LEVEL_ERROR_LENGTH, "%s: kein Speicher fuer die Skripte", path);
+    return RES_FAILED;
+  }
+  ascripts->objects = (struct script_object*) (ascripts->storage + objects_offset);
+  ascripts->changed = (int*) (ascripts->storage + changed_offset);
+  ascripts->code = (uint8_t*) (ascripts->storage + changed_offset + comp.max_changed * sizeof(int));
+  ascripts->code_size = comp.code_size;
+  ascripts->number_of_objects = comp.number_of_objects;
+  ascripts->max_changed = comp.max_changed;
+
+  // Second pass: emit
+  comp.p = text;
+  comp.line = first_line;
+  comp.emit = true;
+  comp.code_size = 0;
+  comp.number_of_objects = 0;
+  comp.max_changed = 0;
+  if (compilePass(&comp) != RES_OK) {
+    releaseLevelScripts(ascripts);
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
+
+void releaseLevelScripts(struct level_scripts* ascripts) {
+  free(ascripts->storage);
+  initializeLevelScripts(ascripts);
+}
+
+// ************************************
+// Running
+// ************************************
+
+static inline uint16_t readOperand(const uint8_t* code) {
+  return code[0] | (code[1] << 8);
+}
+
+static inline bool isInObject(struct script_object* aobject, int y, int x) {
+  return y >= aobject->y && y < aobject->y + aobject->height
+      && x >= aobject->x && x < aobject->x + aobject->width;
+}
+
+// Does the object fit onto the board at (y,x)?
+static bool isObjectOnBoard(struct board* aboard, struct script_object* aobject, int y, int x) {
+  return y >= 0 && x >= 0 && y + aobject->height - 1 <= aboard->last_row
+      && x + aobject->width - 1 <= aboard->last_col;
+}
+
+// Are the cells of the object at (y,x) free, apart from those it
+// covers right now?
+static bool canPlaceObject(struct board* aboard, struct script_object* aobject, int y, int x) {
+  struct pos position;
+
+  if (!isObjectOnBoard(aboard, aobject, y, x)) {
+    return false;
+  }
+  for (position.y = y; position.y < y + aobject->height; position.y++) {
+    for (position.x = x; position.x < x + aobject->width; position.x++) {
+      if (aobject->shown && isInObject(aobject, position.y, position.x)) {
+        continue;
+      }
+      if (getContentAt(aboard, position) != BC_FREE_CELL) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Set the cells of the rectangle at (y,x) of the object's size to code,
+// leaving out those within skip (if any), and record them as changed
+static void setObjectCells(struct level_scripts* ascripts, struct board* aboard,
+                           struct script_object* aobject, int y, int x,
+                           enum BoardCodes code, struct script_object* skip) {
+  int i;
+  int j;
+
+  for (i = y; i < y + aobject->height; i++) {
+    for (j = x; j < x + aobject->width; j++) {
+      if (skip != NULL && isInObject(skip, i, j)) {
+        continue;
+      }
+      setCellContent(aboard, i, j, code);
+      ascripts->changed[ascripts->number_changed++] = getCellIndex(aboard, i, j);
+    }
+  }
+}
+
+// Run the object until it changes the board, waits or ends.
+// Returns the number of instructions executed.
+static int stepObject(struct level_scripts* ascripts, struct board* aboard,
+                      struct script_object* aobject) {
+  const uint8_t* code = ascripts->code;
+  struct script_object moved;
+  int steps;
+  int top;
+  uint16_t count;
+
+  if (aobject->wait > 0) {
+    aobject->wait--;
+    return 0;
+  }
+  for (steps = 1; steps <= SCRIPT_MAX_STEPS; steps++) {
+    const uint8_t* op = code + aobject->pc;
+
+    switch (op[0]) {
+      case OP_END:
+        return steps;
+      case OP_WAIT:
+        aobject->wait = readOperand(op + 1) - 1;
+        aobject->pc += op_sizes[OP_WAIT];
+        return steps;
+      case OP_MOVE:
+        moved = *aobject;
+        moved.y += (int8_t) op[1];
+        moved.x += (int8_t) op[2];
+        // A hidden object only has to stay on the board
+        if (aobject->shown ? !canPlaceObject(aboard, aobject, moved.y, moved.x)
+                           : !isObjectOnBoard(aboard, aobject, moved.y, moved.x)) {
+          return steps;  // Try again in the next tick
+        }
+        if (aobject->shown) {
+          setObjectCells(ascripts, aboard, aobject, aobject->y, aobject->x, BC_FREE_CELL, &moved);
+          setObjectCells(ascripts, aboard, aobject, moved.y, moved.x, BC_BARRIER, aobject);
+        }
+        aobject->y = moved.y;
+        aobject->x = moved.x;
+        aobject->pc += op_sizes[OP_MOVE];
+        return steps;
+      case OP_HIDE:
+        if (aobject->shown) {
+          setObjectCells(ascripts, aboard, aobject, aobject->y, aobject->x, BC_FREE_CELL, NULL);
+          aobject->shown = false;
+        }
+        aobject->pc += op_sizes[OP_HIDE];
+        return steps;
+      case OP_SHOW:
+        if (!aobject->shown) {
+          if (!canPlaceObject(aboard, aobject, aobject->y, aobject->x)) {
+            return steps;
+          }
+          setObjectCells(ascripts, aboard, aobject, aobject->y, aobject->x, BC_BARRIER, NULL);
+          aobject->shown = true;
+        }
+        aobject->pc += op_sizes[OP_SHOW];
+        return steps;
+      case OP_REPEAT:
+        aobject->loop_count[aobject->loop_depth++] = readOperand(op + 1);
+        aobject->pc += op_sizes[OP_REPEAT];
+        break;
+      case OP_NEXT:
+        top = aobject->loop_depth - 1;
+        count = aobject->loop_count[top];
+        if (count == 0 || --aobject->loop_count[top] > 0) {
+          aobject->pc = readOperand(op + 1);
+        } else {
+          aobject->loop_depth--;
+          aobject->pc += op_sizes[OP_NEXT];
+        }
+        break;
+    }
+  }
+  // A loop without WAIT or changes: go on in the next tick
+  return steps - 1;
+}
+
+// Run all scripts for one tick.
+// The board is changed right away; the indices of the changed cells are
+// left in ascripts->changed for the display (see redrawCells()).
+// Returns the number of changed cells.
+int runLevelScripts(struct level_scripts* ascripts, struct board* aboard) {
+  struct timespec start;
+  struct timespec stop;
+  int i;
+
+  if (ascripts->number_of_objects == 0) {
+    return 0;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ascripts->number_changed = 0;
+  for (i = 0; i < ascripts->number_of_objects; i++) {
+    ascripts->instructions += stepObject(ascripts, aboard, &ascripts->objects[i]);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  ascripts->ticks++;
+  ascripts->nanoseconds += (stop.tv_sec - start.tv_sec) * 1000000000LL
+                           + (stop.tv_nsec - start.tv_nsec);
+  return ascripts->number_changed;
+}
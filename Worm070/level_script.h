@@ -0,0 +1,79 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Moving barriers driven by small scripts
+//
+// A level file may end with scripts, one per moving object.
+// An object is a rectangle of barrier cells:
+//
+//   SCRIPT <y> <x> <height> <width>   the object and its start position
+//   MOVE <dy> <dx>    shift the object; waits while the target is not free
+//   WAIT <ticks>      do nothing for a number of ticks
+//   HIDE              take the object off the board (open a gate)
+//   SHOW              put it back; waits while its cells are not free
+//   REPEAT <count>    repeat the lines up to the matching NEXT;
+//   NEXT              count 0 repeats forever
+//   END               end of the script; the object stays where it is
+//
+// Empty lines and lines starting with ';' are ignored.
+// The scripts are compiled to bytecode when the level is loaded.
+// Every tick each object runs until it changes the board or waits.
+
+#ifndef _LEVEL_SCRIPT_H
+#define _LEVEL_SCRIPT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "worm.h"
+#include "board_model.h"
+
+#define LEVEL_SCRIPT_KEYWORD "SCRIPT"  // First word of a script
+#define LEVEL_SCRIPT_COMMENT ';'       // Starts a comment line
+#define SCRIPT_MAX_LOOP_DEPTH 4        // Nesting depth of REPEAT
+#define SCRIPT_MAX_STEPS 64            // Instructions per object and tick
+
+// A scripted object
+struct script_object {
+    int y;         // Top left corner
+    int x;
+    int height;
+    int width;
+    bool shown;    // Are its cells on the board?
+    uint32_t pc;   // Offset of the next instruction in the bytecode
+    int wait;      // Ticks to wait before the next instruction
+    int loop_depth;                              // Number of open REPEATs
+    uint16_t loop_count[SCRIPT_MAX_LOOP_DEPTH];  // Repetitions left; 0: forever
+};
+
+// All scripts of a level
+struct level_scripts {
+    char* storage;      // One block for all arrays below; NULL if there are no scripts
+    uint8_t* code;      // Bytecode of all objects
+    size_t code_size;
+    struct script_object* objects;
+    int number_of_objects;
+    int* changed;       // Indices of the cells changed in the last tick
+    int number_changed;
+    size_t max_changed; // Size of changed: enough for every object's largest step
+
+    // Cost of the scripts in this level
+    long long ticks;
+    long long instructions;
+    long long nanoseconds;
+};
+
+extern void initializeLevelScripts(struct level_scripts* ascripts);
+extern enum ResCodes compileLevelScripts(struct level_scripts* ascripts, struct board* aboard,
+                                         const char* text, const char* end, int first_line,
+                                         const char* path, char* error);
+extern int runLevelScripts(struct level_scripts* ascripts, struct board* aboard);
+extern void releaseLevelScripts(struct level_scripts* ascripts);
+
+#endif  // #define _LEVEL_SCRIPT_H
@@ -14,6 +14,7 @@
 #include "worm.h"
 #include "board_model.h"
 #include "worm_model.h"
+#include "level_script.h"
 #include "messages.h"
 
 // Clear an entire line on the display
@@ -27,15 +28,35 @@ void clearLineInMessageArea(int row) {
 }
 
 // Display status about the game in the message area
-void showStatus(struct board* aboard, struct worm* aworm) {
+void showStatus(struct board* aboard, struct worm_set* aworms) {
     int pos_line1 = LINES -ROWS_RESERVED + 1;
     int pos_line2 = LINES -ROWS_RESERVED + 2;
     int pos_line3 = LINES -ROWS_RESERVED + 3;
 
-    struct pos headpos = getWormHeadPos(aworm);
-    mvprintw(pos_line1, 1,"Anzahl verbleibender Futterbrocken: %2d ", getNumberOfFoodItems(aboard));
+    struct pos headpos = getWormHeadPos(aworms, aboard, USER_WORM);
+    mvprintw(pos_line1, 1,"Anzahl verbleibender Futterbrocken: %2d (%c: %2d  %c: %2d  %c: %2d) ",
+        getNumberOfFoodItems(aboard),
+        SYMBOL_FOOD_1, getNumberOfFoodItemsOfType(aboard, BC_FOOD_1),
+        SYMBOL_FOOD_2, getNumberOfFoodItemsOfType(aboard, BC_FOOD_2),
+        SYMBOL_FOOD_3, getNumberOfFoodItemsOfType(aboard, BC_FOOD_3));
     mvprintw(pos_line2, 1,"Wurm ist an Position: y=%3d x=%3d", headpos.y, headpos.x);
-    mvprintw(pos_line3, 1,"Laenge des Wurms: %3d", getWormLength(aworm) );
+    if (aworms->count > 1) {
+        mvprintw(pos_line2, 40,"In Ihren Wurm gelaufen: %3d", getWormKills(aworms, USER_WORM));
+    }
+    mvprintw(pos_line3, 1,"Laenge des Wurms: %3d", getWormLength(aworms, USER_WORM) );
+}
+
+// Display the cost of the moving barriers of the level (if any)
+void showScriptStatus(struct level_scripts* ascripts) {
+    int pos_line3 = LINES -ROWS_RESERVED + 3;
+
+    if (ascripts->number_of_objects == 0 || ascripts->ticks == 0) {
+        return;
+    }
+    mvprintw(pos_line3, 30, "Skripte: %d Objekte, %6lld ns und %4lld Befehle pro Zug",
+        ascripts->number_of_objects,
+        ascripts->nanoseconds / ascripts->ticks,
+        ascripts->instructions / ascripts->ticks);
 }
 
 // Display a dialog in the message area and wait for confirmation
@@ -15,9 +15,11 @@
 #include "worm.h"
 #include "worm_model.h"
 #include "board_model.h"
+#include "level_script.h"
 
 extern void clearLineInMessageArea(int row);
-extern void showStatus(struct board* aboard, struct worm* aworm);
+extern void showStatus(struct board* aboard, struct worm_set* aworms);
+extern void showScriptStatus(struct level_scripts* ascripts);
 extern int showDialog(char* prompt1, char* prompt2);
 
 #endif  // #define _MESSAGES_H
@@ -0,0 +1,44 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// A small pseudo random number generator (splitmix64)
+
+#include <stdint.h>
+#include "rng.h"
+
+// Start a new sequence of random numbers
+void seedRng(struct rng* arng, uint64_t seed) {
+  arng->state = seed;
+}
+
+// Next random number of the sequence
+uint64_t nextRandom(struct rng* arng) {
+  uint64_t z = (arng->state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Uniformly distributed random number in 0 .. bound - 1 (bound > 0)
+uint32_t nextRandomBelow(struct rng* arng, uint32_t bound) {
+  // Multiply and shift; reject the few values that would make
+  // the result biased (Lemire's method)
+  uint64_t m = (uint64_t) (uint32_t) nextRandom(arng) * bound;
+  uint32_t low = (uint32_t) m;
+  uint32_t threshold;
+
+  if (low < bound) {
+    threshold = -bound % bound;
+    while (low < threshold) {
+      m = (uint64_t) (uint32_t) nextRandom(arng) * bound;
+      low = (uint32_t) m;
+    }
+  }
+  return m >> 32;
+}
@@ -0,0 +1,28 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// A small pseudo random number generator
+//
+// Unlike rand() the sequence depends on the seed only; it is the same
+// with every C library and on every machine.
+
+#ifndef _RNG_H
+#define _RNG_H
+
+#include <stdint.h>
+
+struct rng {
+    uint64_t state;
+};
+
+extern void seedRng(struct rng* arng, uint64_t seed);
+extern uint64_t nextRandom(struct rng* arng);
+extern uint32_t nextRandomBelow(struct rng* arng, uint32_t bound);
+
+#endif  // #define _RNG_H
@@ -0,0 +1,139 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Swarm benchmark
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include "worm.h"
+#include "rng.h"
+#include "level.h"
+#include "level_image.h"
+#include "board_model.h"
+#include "worm_model.h"
+#include "swarm.h"
+
+// Seconds on a monotonic clock, for timing the benchmarks
+double getBenchmarkSeconds(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Let the swarm run for SWARM_TICKS ticks. Eaten food grows again so that
+// the worms keep on growing. Only stepWorms() is timed.
+static enum ResCodes runSwarm(struct game_settings* asettings, bool vector_aim,
+                              struct swarm_run* arun) {
+  struct level thelevel;
+  struct worm_set worms;
+  struct rng swarm_rng;
+  struct pos position;
+  int food_target[NUMBER_OF_FOOD_TYPES];
+  double start;
+  int tick;
+  int i;
+
+  if (setupLevel(&thelevel, asettings) != RES_OK) {
+    fprintf(stderr, "%s\n", thelevel.error);
+    return RES_FAILED;
+  }
+  if (initializeWorms(&worms, &thelevel.board, asettings->swarm_size) != RES_OK) {
+    fprintf(stderr, "Kein Speicher fuer %d Wuermer\n", asettings->swarm_size);
+    releaseLevel(&thelevel);
+    return RES_FAILED;
+  }
+  worms.vector_aim = vector_aim;
+
+  for (i = 0; i < NUMBER_OF_FOOD_TYPES; i++) {
+    food_target[i] = getNumberOfFoodItemsOfType(&thelevel.board, BC_FOOD_1 + i);
+  }
+  seedRng(&swarm_rng, asettings->seed);
+  for (i = 0; i < asettings->swarm_size
+       && pickRandomFreeCell(&thelevel.board, &swarm_rng, &position); i++) {
+    if (addWorm(&worms, &thelevel.board, WORM_INITIAL_LENGTH, position,
+                nextRandomBelow(&swarm_rng, WORM_UP_LEFT), COLP_STEERED_WORM, true) < 0) {
+      fprintf(stderr, "Kein Speicher fuer %d Wuermer\n", asettings->swarm_size);
+      releaseWorms(&worms);
+      releaseLevel(&thelevel);
+      return RES_FAILED;
+    }
+  }
+
+  arun->rows = getLastRowOnBoard(&thelevel.board) + 1;
+  arun->cols = getLastColOnBoard(&thelevel.board) + 1;
+  arun->worm_steps = 0;
+  arun->seconds = 0;
+  for (tick = 0; tick < SWARM_TICKS; tick++) {
+    steerWorms(&worms, &thelevel.board, &swarm_rng);
+    for (i = 0; i < worms.count; i++) {
+      arun->worm_steps += getWormState(&worms, i) == WORM_GAME_ONGOING;
+    }
+    start = getBenchmarkSeconds();
+    stepWorms(&worms, &thelevel.board);
+    arun->seconds += getBenchmarkSeconds() - start;
+    replenishFood(&thelevel.board, &swarm_rng, food_target);
+  }
+
+  arun->survivors = 0;
+  for (i = 0; i < worms.count; i++) {
+    arun->survivors += getWormState(&worms, i) == WORM_GAME_ONGOING;
+  }
+  arun->hash = hashLevelImage(thelevel.board.storage, thelevel.board.storage_size);
+  releaseWorms(&worms);
+  releaseLevel(&thelevel);
+  return RES_OK;
+}
+
+// Tell about one run
+static void showSwarmRun(const char* name, struct swarm_run* arun, int swarm_size) {
+  printf("%-8s %lld Wurm-Schritte in %.3f s: %.2f Mio. Schritte/s, "
+      "%d von %d Wuermern leben, Pruefsumme %016llx\n",
+      name, arun->worm_steps, arun->seconds,
+      arun->seconds > 0 ? arun->worm_steps / arun->seconds * 1e-6 : 0.0,
+      arun->survivors, swarm_size, (unsigned long long) arun->hash);
+}
+
+// Run the swarm with the scalar and the vector code and compare.
+// Runs without curses; messages go to stdout and stderr.
+enum ResCodes runSwarmBenchmark(struct game_settings* asettings) {
+  struct swarm_run scalar_run;
+  struct swarm_run vector_run;
+
+  if (asettings->rows == 0) {
+    asettings->rows = SWARM_DEFAULT_ROWS;
+  }
+  if (asettings->cols == 0) {
+    asettings->cols = SWARM_DEFAULT_COLS;
+  }
+  if (runSwarm(asettings, false, &scalar_run) != RES_OK) {
+    return RES_FAILED;
+  }
+  // A level file brings its own size
+  printf("Schwarm: %d Wuermer auf %dx%d Zellen, %d Takte\n",
+      asettings->swarm_size, scalar_run.rows, scalar_run.cols, SWARM_TICKS);
+  showSwarmRun("Skalar:", &scalar_run, asettings->swarm_size);
+  if (!WORM_VECTOR_AIM) {
+    printf("Vektor:  nicht eingebaut (mit -mavx2 uebersetzen, siehe Makefile)\n");
+    return RES_OK;
+  }
+  if (runSwarm(asettings, true, &vector_run) != RES_OK) {
+    return RES_FAILED;
+  }
+  showSwarmRun("Vektor:", &vector_run, asettings->swarm_size);
+  if (vector_run.hash != scalar_run.hash) {
+    fprintf(stderr, "Fehler: die beiden Laeufe enden mit verschiedenen Spielfeldern\n");
+    return RES_FAILED;
+  }
+  if (vector_run.seconds > 0) {
+    printf("Beschleunigung: %.2f\n", scalar_run.seconds / vector_run.seconds);
+  }
+  return RES_OK;
+}
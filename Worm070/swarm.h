@@ -0,0 +1,40 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Swarm benchmark: thousands of worms steered by the computer on one
+// large board, stepped without the display.
+//
+// The same swarm runs once with the scalar code and once with the vector
+// code of stepWorms() (if built in, see WORM_VECTOR_AIM). Both runs start
+// from the same seed and must end with the same board.
+
+#ifndef _SWARM_H
+#define _SWARM_H
+
+#include <stdint.h>
+#include "worm.h"
+
+#define SWARM_DEFAULT_ROWS 1000  // Size of the board unless given by -r and -c
+#define SWARM_DEFAULT_COLS 1000
+#define SWARM_TICKS 1000         // Number of ticks of a run
+
+// Outcome of one run of the swarm
+struct swarm_run {
+    int rows;             // Dimensions of the board the swarm ran on
+    int cols;
+    long long worm_steps; // Steps of living worms summed over all ticks
+    double seconds;       // Time spent in stepWorms()
+    int survivors;        // Worms still alive after the last tick
+    uint64_t hash;        // Content hash of the board after the last tick
+};
+
+extern double getBenchmarkSeconds(void);
+extern enum ResCodes runSwarmBenchmark(struct game_settings* asettings);
+
+#endif  // #define _SWARM_H
@@ -1,242 +1,625 @@
-// A simple variant of the game Snake
-//
-// Used for teaching in classes
-//
-// Author:
-// Franz Regensburger
-// Ingolstadt University of Applied Sciences
-// (C) 2011
-//
-
-#include <curses.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdbool.h>
-#include <time.h>
-#include <string.h>
-#include <unistd.h>
-
-#include "prep.h"
-#include "messages.h"
-#include "worm.h"
-#include "worm_model.h"
-#include "board_model.h"
-
-// Management of the game
-void initializeColors();
-void readUserInput(struct worm* aworm, enum GameStates* agame_state );
-enum ResCodes doLevel();
-
-// ************************************
-// Management of the game
-// ************************************
-
-// Initialize colors of the game
-void initializeColors() {
-  // Define colors of the game
-  start_color();
-  init_pair(COLP_USER_WORM, COLOR_GREEN,   COLOR_BLACK);
-  init_pair(COLP_FREE_CELL, COLOR_BLACK,   COLOR_BLACK);
-  init_pair(COLP_FOOD_1,    COLOR_YELLOW,  COLOR_BLACK);
-  init_pair(COLP_FOOD_2,    COLOR_MAGENTA, COLOR_BLACK);
-  init_pair(COLP_FOOD_3,    COLOR_CYAN,    COLOR_BLACK);
-  init_pair(COLP_BARRIER,   COLOR_RED,     COLOR_BLACK);
-  init_pair(COLP_WORM_HEAD, COLOR_GREEN,     COLOR_BLACK);
-}
-
-void readUserInput(struct worm* aworm, enum GameStates* agame_state ) {
-  int ch; // For storing the key codes
-
-  if ((ch = getch()) > 0) {
-    // Is there some user input?
-    // Blocking or non-blocking depends of config of getch
-    switch(ch) {
-      case 'q' :    // User wants to end the show
-        *agame_state = WORM_GAME_QUIT;
-        break;
-      case 'g': // Cheatey Time
-        growWorm(aworm, BONUS_3);
-        break;
-      case KEY_UP :// User wants up
-        setWormHeading(aworm, WORM_UP);
-        break;
-      case KEY_DOWN :// User wants down
-        setWormHeading(aworm, WORM_DOWN);
-        break;
-      case KEY_LEFT :// User wants left
-        setWormHeading(aworm, WORM_LEFT);
-        break;
-      case KEY_RIGHT :// User wants right
-        setWormHeading(aworm, WORM_RIGHT);
-        break;
-      case 's' : // User wants single step
-        nodelay(stdscr, FALSE); // We simply make getch blocking
-        break;
-      case ' ' : // Terminate single step; make getch non-blocking again
-        nodelay(stdscr, TRUE);  // Make getch non-blocking again
-        break;
-    }
-  }
-  return;
-}
-
-enum ResCodes doLevel() {
-  struct worm userworm; // Local variable for storing user's worm
-  struct board theboard; // Our game board
-  enum GameStates game_state; // The current game_state
-
-  enum ResCodes res_code; // Result code from functions
-  bool end_level_loop;    // Indicates whether we should leave the main loop
-
-  struct pos bottomLeft;   // Start positions of the worm
-
-  // At the beginnung of the level, we still have a chance to win
-  game_state = WORM_GAME_ONGOING;
-
-  // Setup the board
-  res_code = initializeBoard(&theboard);
-  if(res_code != RES_OK){
-    return res_code;
-  }
-
-  // Initialize the current Level
-  res_code = initializeLevel(&theboard);
-  if(res_code != RES_OK){
-    return res_code;
-  }
-  
-
-  // There is always an initialized user worm.
-  // Initialize the userworm with its size, position, heading.
-  bottomLeft.y =  getLastRowOnBoard(&theboard)/2;
-  bottomLeft.x =  0;
-
-  res_code = initializeWorm(&userworm, WORM_LENGTH, WORM_INITIAL_LENGTH, bottomLeft, WORM_RIGHT, COLP_USER_WORM);
-  if ( res_code != RES_OK) {
-    return res_code;
-  }
-  
-  // Show worm at its initial position
-  showWorm(&theboard, &userworm);
-
-  // Display all what we have set up until now
-  refresh();
-
-  // Start the loop for this level
-  end_level_loop = false; // Flag for controlling the main loop
-  while(!end_level_loop) {
-    // Process optional user input
-    readUserInput(&userworm ,&game_state); 
-    if ( game_state == WORM_GAME_QUIT ) {
-      end_level_loop = true;
-      continue; // Go to beginning of the loop's block and check loop condition
-    }
-
-    // Process userworm
-    cleanWormTail(&theboard, &userworm);
-    // Now move the worm for one step
-    moveWorm(&theboard, &userworm, &game_state);
-    // Bail out of the loop if something bad happened
-    if ( game_state != WORM_GAME_ONGOING ) {
-      end_level_loop = true;
-      //showDialog("We locked out???","worm.c 141");
-      continue; // Go to beginning of the loop's block and check loop condition
-    }
-    // Show the worm at its new positionSYMBOL_WORM_INNER_ELEMENT
-    showWorm(&theboard, &userworm);
-    // END process userworm
-    
-    // Inform user about position and length of userworm in status window
-    showStatus(&theboard, &userworm);
-
-    // Sleep a bit before we show the updated window
-    napms(NAP_TIME);
-
-    // Display all the updates
-    refresh();
-
-    //Are we done with the level?
-    if (getNumberOfFoodItems(&theboard) == 0){
-      end_level_loop = true;
-    }
-
-    // Start next iteration
-  }
-
-  // Preset res_code for rest of the function
-  res_code = RES_OK;
-
-  // For some reason we left the control loop of the current level.
-  // Check why according to game_state
-  switch(game_state){
-    case WORM_GAME_ONGOING:
-      if(getNumberOfFoodItems(&theboard) == 0){
-        showDialog("Sie haben diese Runde erfolgreich beendet!!",
-            "Bitte Taste druecken!");
-      } else {
-        showDialog("Interner Fehler!","Bitte Taste druecken");
-        // Set error result code. This should -technically- never happen.
-        res_code = RES_INTERNAL_ERROR;
-      }
-      break;
-    case WORM_GAME_QUIT:
-      //User must have typed 'q' for quit
-      showDialog("Sie haben die aktuelle Runde abgebrochen!",
-          "Bitte Taste druecken");
-      break;
-    case WORM_CRASH:
-      showDialog("Sie haben das Spiel verloren, weil Sie in die Barriere gefahren sind.",
-          "Bitte Taste druecke");
-    case WORM_OUT_OF_BOUNDS:
-      showDialog("Sie haben das Spiel verloren, weil Sie das Spielfeld verlassen haben",
-          "Bitte Taste druecken");
-      break;
-    case WORM_CROSSING:
-      showDialog("Sie haben das Spiel verloren, weil Sie einen Wurm gekreuzt haben",
-          "Bitte Taste druecken");
-      break;
-    default:
-      showDialog("Interner Fehler!","Bitte Taste druecken");
-      // Set error result code. This should -technically- never happen.
-      res_code = RES_INTERNAL_ERROR;
-
-  }
-
-  // Normal exit point
-  return res_code;
-}
-
-// END WORM_DETAIL
-// ********************************************************************************************
-
-// ********************************************************************************************
-// MAIN
-// ********************************************************************************************
-
-int main(void) {
-  int res_code;         // Result code from functions
-
-  // Here we start
-  initializeCursesApplication();  // Init various settings of our application
-  initializeColors();             // Init colors used in the game
-
-  // Maximal LINES and COLS are set by curses for the current window size.
-  // Note: we do not cope with resizing in this simple examples!
-
-  // Check if the window is large enough to display messages in the message area
-  // a has space for at least MIN_NUMBER_OF_ROWS lines for the worm
-  if ( LINES < ROWS_RESERVED + MIN_NUMBER_OF_ROWS || COLS < MIN_NUMBER_OF_COLS ) {
-    // Since we not even have the space for displaying messages
-    // we print a conventional error message via printf after
-    // the call of cleanupCursesApp()
-    cleanupCursesApp();
-    printf("Das Fenster ist zu klein: wir brauchen mindestens %dx%d\n",
-        MIN_NUMBER_OF_COLS, MIN_NUMBER_OF_ROWS + ROWS_RESERVED);
-    res_code = RES_FAILED;
-  } else {
-    res_code = doLevel();
-    cleanupCursesApp();
-  }
-
-  return res_code;
-}
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+
+#include <curses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "prep.h"
+#include "messages.h"
+#include "worm.h"
+#include "arena.h"
+#include "rng.h"
+#include "level.h"
+#include "level_image.h"
+#include "level_check.h"
+#include "level_preload.h"
+#include "worm_model.h"
+#include "board_model.h"
+#include "entity.h"
+#include "swarm.h"
+#include "board_bench.h"
+
+// Management of the game
+void initializeColors();
+void readUserInput(struct board* aboard, struct worm_set* aworms, enum GameStates* agame_state );
+enum ResCodes doLevel(struct level_preload* aloaded, struct game_settings* asettings,
+                      bool last_level);
+void getLevelSettings(struct game_settings* asettings, int level,
+                      struct game_settings* alevel_settings);
+enum ResCodes playLevels(struct game_settings* asettings);
+void showUsage(char* progname);
+enum ResCodes convertLevel(struct game_settings* asettings);
+enum ResCodes generateLevels(struct game_settings* asettings);
+enum ResCodes playInWindow(struct game_settings* asettings);
+
+// ************************************
+// Management of the game
+// ************************************
+
+// Initialize colors of the game
+void initializeColors() {
+  // Define colors of the game
+  start_color();
+  init_pair(COLP_USER_WORM, COLOR_GREEN,   COLOR_BLACK);
+  init_pair(COLP_FREE_CELL, COLOR_BLACK,   COLOR_BLACK);
+  init_pair(COLP_FOOD_1,    COLOR_YELLOW,  COLOR_BLACK);
+  init_pair(COLP_FOOD_2,    COLOR_MAGENTA, COLOR_BLACK);
+  init_pair(COLP_FOOD_3,    COLOR_CYAN,    COLOR_BLACK);
+  init_pair(COLP_BARRIER,   COLOR_RED,     COLOR_BLACK);
+  init_pair(COLP_WORM_HEAD, COLOR_GREEN,     COLOR_BLACK);
+  init_pair(COLP_STEERED_WORM, COLOR_BLUE, COLOR_BLACK);
+}
+
+void readUserInput(struct board* aboard, struct worm_set* aworms, enum GameStates* agame_state ) {
+  int ch; // For storing the key codes
+
+  if ((ch = getch()) > 0) {
+    // Is there some user input?
+    // Blocking or non-blocking depends of config of getch
+    switch(ch) {
+      case 'q' :    // User wants to end the show
+        *agame_state = WORM_GAME_QUIT;
+        break;
+      case 'g': // Cheatey Time
+        growWorm(aworms, USER_WORM, BONUS_3);
+        break;
+      case KEY_UP :// User wants up
+        setWormHeading(aworms, USER_WORM, WORM_UP);
+        break;
+      case KEY_DOWN :// User wants down
+        setWormHeading(aworms, USER_WORM, WORM_DOWN);
+        break;
+      case KEY_LEFT :// User wants left
+        setWormHeading(aworms, USER_WORM, WORM_LEFT);
+        break;
+      case KEY_RIGHT :// User wants right
+        setWormHeading(aworms, USER_WORM, WORM_RIGHT);
+        break;
+      case 'a' : // User wants up_left
+        if (isBoardDiagonal(aboard)) {
+          setWormHeading(aworms, USER_WORM, WORM_UP_LEFT);
+        }
+        break;
+      case 'w' : // User wants up_right
+        if (isBoardDiagonal(aboard)) {
+          setWormHeading(aworms, USER_WORM, WORM_UP_RIGHT);
+        }
+        break;
+      case 'y' : // User wants down_left
+        if (isBoardDiagonal(aboard)) {
+          setWormHeading(aworms, USER_WORM, WORM_DOWN_LEFT);
+        }
+        break;
+      case 'd' : // User wants down_right
+        if (isBoardDiagonal(aboard)) {
+          setWormHeading(aworms, USER_WORM, WORM_DOWN_RIGHT);
+        }
+        break;
+      case 's' : // User wants single step
+        nodelay(stdscr, FALSE); // We simply make getch blocking
+        break;
+      case ' ' : // Terminate single step; make getch non-blocking again
+        nodelay(stdscr, TRUE);  // Make getch non-blocking again
+        break;
+    }
+  }
+  return;
+}
+
+// Play a level loaded by finishPreload().
+// The caller releases the level afterwards.
+// A successful level only ends with a dialog if it is the last one.
+enum ResCodes doLevel(struct level_preload* aloaded, struct game_settings* asettings,
+                      bool last_level) {
+  struct level* thelevel = &aloaded->level; // Our game board and the memory of the level
+  struct worm_set worms; // The user's worm and the worms steered by the computer
+  struct entity_table entities; // Items with a limited lifetime
+  enum GameStates game_state; // The current game_state
+
+  enum ResCodes res_code; // Result code from functions
+  bool end_level_loop;    // Indicates whether we should leave the main loop
+
+  struct pos bottomLeft;   // Start positions of the worm
+  struct pos position;     // Start positions of the other worms
+
+  struct rng level_rng;    // Random numbers for placing new food
+  int food_target[NUMBER_OF_FOOD_TYPES]; // Food per type at the start of the level
+  int t;
+  int tick;                // Number of ticks played
+
+  // At the beginnung of the level, we still have a chance to win
+  game_state = WORM_GAME_ONGOING;
+
+  // Remember the food of the level; eaten food may be replaced later on
+  for (t = 0; t < NUMBER_OF_FOOD_TYPES; t++) {
+    food_target[t] = getNumberOfFoodItemsOfType(&thelevel->board, BC_FOOD_1 + t);
+  }
+  seedRng(&level_rng, time(NULL));
+
+
+  // There is always an initialized user worm: the first one of the set.
+  // Initialize the userworm with its size, position, heading.
+  // The worms steered by the computer start at random free cells.
+  bottomLeft = getStartPosition(&thelevel->board);
+
+  res_code = initializeWorms(&worms, &thelevel->board, 1 + asettings->steered_worms);
+  if ( res_code != RES_OK) {
+    return res_code;
+  }
+  if (addWorm(&worms, &thelevel->board, WORM_INITIAL_LENGTH, bottomLeft, WORM_RIGHT,
+              COLP_USER_WORM, false) != USER_WORM) {
+    releaseWorms(&worms);
+    return RES_FAILED;
+  }
+  for (t = 0; t < asettings->steered_worms
+       && pickRandomFreeCell(&thelevel->board, &level_rng, &position); t++) {
+    if (addWorm(&worms, &thelevel->board, WORM_INITIAL_LENGTH, position,
+                nextRandomBelow(&level_rng, WORM_UP_LEFT), COLP_STEERED_WORM, true) < 0) {
+      releaseWorms(&worms);
+      return RES_FAILED;
+    }
+  }
+  res_code = initializeEntityTable(&entities, &thelevel->arena, ENTITY_CAPACITY);
+  if ( res_code != RES_OK) {
+    releaseWorms(&worms);
+    return res_code;
+  }
+  
+  // Show the board and the worms at their initial positions.
+  // The board has been rendered while loading; we only copy it.
+  erase();
+  showPrerenderedBoard(aloaded->screen, aloaded->screen_rows, aloaded->screen_cols);
+  showWorms(&worms, &thelevel->board);
+
+  // Display all what we have set up until now
+  refresh();
+
+  // Start the loop for this level
+  end_level_loop = false; // Flag for controlling the main loop
+  tick = 0;
+  while(!end_level_loop) {
+    tick++;
+    // Process optional user input
+    readUserInput(&thelevel->board, &worms ,&game_state); 
+    if ( game_state == WORM_GAME_QUIT ) {
+      end_level_loop = true;
+      continue; // Go to beginning of the loop's block and check loop condition
+    }
+
+    // Move the scripted barriers and show the cells they changed
+    if (runLevelScripts(&thelevel->scripts, &thelevel->board) > 0) {
+      redrawCells(&thelevel->board, thelevel->scripts.changed, thelevel->scripts.number_changed);
+    }
+
+    // Now move all worms for one step and show them at their new positions
+    steerWorms(&worms, &thelevel->board, &level_rng);
+    stepWorms(&worms, &thelevel->board);
+    showWorms(&worms, &thelevel->board);
+    // Bail out of the loop if something bad happened to the user's worm
+    game_state = getWormState(&worms, USER_WORM);
+    if ( game_state != WORM_GAME_ONGOING ) {
+      end_level_loop = true;
+      //showDialog("We locked out???","worm.c 141");
+      continue; // Go to beginning of the loop's block and check loop condition
+    }
+
+    // Eaten food grows again somewhere else
+    if (asettings->respawn_food) {
+      replenishFood(&thelevel->board, &level_rng, food_target);
+    }
+
+    // Items with a lifetime age; fleeting food shows up now and then
+    if (updateEntities(&entities, &thelevel->board) > 0) {
+      redrawCells(&thelevel->board, entities.changed, entities.number_changed);
+    }
+    if (asettings->fleeting_food && tick % FLEETING_FOOD_INTERVAL == 0) {
+      spawnEntity(&entities, &thelevel->board, &level_rng, ET_FLEETING_FOOD, ENTITY_NO_OWNER);
+    }
+    
+    // Inform user about position and length of userworm in status window
+    showStatus(&thelevel->board, &worms);
+    showScriptStatus(&thelevel->scripts);
+
+    // Sleep a bit before we show the updated window
+    napms(NAP_TIME);
+
+    // Display all the updates
+    refresh();
+
+    //Are we done with the level?
+    if (getNumberOfFoodItems(&thelevel->board) == 0){
+      end_level_loop = true;
+    }
+
+    // Start next iteration
+  }
+
+  // Preset res_code for rest of the function
+  res_code = RES_OK;
+
+  // For some reason we left the control loop of the current level.
+  // Check why according to game_state
+  switch(game_state){
+    case WORM_GAME_ONGOING:
+      if(getNumberOfFoodItems(&thelevel->board) == 0){
+        // Go on with the next level without delay
+        if (last_level) {
+          showDialog("Sie haben diese Runde erfolgreich beendet!!",
+              "Bitte Taste druecken!");
+        }
+      } else {
+        showDialog("Interner Fehler!","Bitte Taste druecken");
+        // Set error result code. This should -technically- never happen.
+        res_code = RES_INTERNAL_ERROR;
+      }
+      break;
+    case WORM_GAME_QUIT:
+      //User must have typed 'q' for quit
+      showDialog("Sie haben die aktuelle Runde abgebrochen!",
+          "Bitte Taste druecken");
+      break;
+    case WORM_CRASH:
+      showDialog("Sie haben das Spiel verloren, weil Sie in die Barriere gefahren sind.",
+          "Bitte Taste druecke");
+    case WORM_OUT_OF_BOUNDS:
+      showDialog("Sie haben das Spiel verloren, weil Sie das Spielfeld verlassen haben",
+          "Bitte Taste druecken");
+      break;
+    case WORM_CROSSING:
+      if (getWormHit(&worms, USER_WORM) == USER_WORM) {
+        showDialog("Sie haben das Spiel verloren, weil Sie Ihren Wurm gekreuzt haben",
+            "Bitte Taste druecken");
+      } else {
+        showDialog("Sie haben das Spiel verloren, weil Sie in einen anderen Wurm gefahren sind",
+            "Bitte Taste druecken");
+      }
+      break;
+    default:
+      showDialog("Interner Fehler!","Bitte Taste druecken");
+      // Set error result code. This should -technically- never happen.
+      res_code = RES_INTERNAL_ERROR;
+
+  }
+
+  // Normal exit point
+  releaseWorms(&worms);
+  return res_code;
+}
+
+// The settings of level number level of the game:
+// the next level file or the next seed
+void getLevelSettings(struct game_settings* asettings, int level,
+                      struct game_settings* alevel_settings) {
+  *alevel_settings = *asettings;
+  if (asettings->number_of_level_paths > 0) {
+    alevel_settings->level_path = asettings->level_paths[level];
+  } else if (asettings->generate) {
+    alevel_settings->seed = asettings->seed + level;
+  }
+}
+
+// Play all levels one after another.
+// Each level is loaded in the background while the one before is played.
+enum ResCodes playLevels(struct game_settings* asettings) {
+  struct level_preload preloads[2]; // The level played and the next one
+  struct level_preload* current;
+  struct game_settings level_settings;
+  int number_of_levels;
+  int window_rows = LINES - ROWS_RESERVED;
+  int level;
+  bool level_done;
+  enum ResCodes res_code;
+
+  if (asettings->number_of_level_paths > 0) {
+    number_of_levels = asettings->number_of_level_paths;
+  } else if (asettings->batch_count > 0) {
+    number_of_levels = asettings->batch_count;
+  } else {
+    number_of_levels = 1;
+  }
+
+  getLevelSettings(asettings, 0, &level_settings);
+  startPreload(&preloads[0], &level_settings, window_rows, COLS);
+  for (level = 0; level < number_of_levels; level++) {
+    current = &preloads[level % 2];
+    res_code = finishPreload(current);
+    if (res_code != RES_OK) {
+      showDialog(current->level.error, "Bitte eine Taste druecken");
+      return res_code;
+    }
+    if (current->removed_food > 0) {
+      showDialog("Nicht erreichbares Futter wurde aus dem Level entfernt",
+          "Bitte eine Taste druecken");
+    }
+    // Load the next level while this one is played
+    if (level + 1 < number_of_levels) {
+      getLevelSettings(asettings, level + 1, &level_settings);
+      startPreload(&preloads[(level + 1) % 2], &level_settings, window_rows, COLS);
+    }
+
+    res_code = doLevel(current, asettings, level + 1 == number_of_levels);
+    level_done = getNumberOfFoodItems(&current->level.board) == 0;
+
+    // Release board and worm of the level in one go
+    releasePreloadScreen(current);
+    releaseLevel(&current->level);
+
+    // The next level is only played after a successful one
+    if (res_code != RES_OK || !level_done) {
+      // Wait for the next level before throwing it away
+      if (level + 1 < number_of_levels
+          && finishPreload(&preloads[(level + 1) % 2]) == RES_OK) {
+        releasePreloadScreen(&preloads[(level + 1) % 2]);
+        releaseLevel(&preloads[(level + 1) % 2].level);
+      }
+      return res_code;
+    }
+  }
+  return RES_OK;
+}
+
+// END WORM_DETAIL
+// ********************************************************************************************
+
+// ********************************************************************************************
+// MAIN
+// ********************************************************************************************
+
+// Write the level given by the settings as level image (see level_image.h).
+// Runs without curses; messages go to stdout and stderr.
+enum ResCodes convertLevel(struct game_settings* asettings) {
+  struct level thelevel;
+  struct level_check check;
+  enum ResCodes res_code;
+  uint64_t hash;
+
+  // Without a window the built-in level gets the guaranteed size
+  if (asettings->rows == 0) {
+    asettings->rows = MIN_NUMBER_OF_ROWS;
+  }
+  if (asettings->cols == 0) {
+    asettings->cols = MIN_NUMBER_OF_COLS;
+  }
+  res_code = setupLevel(&thelevel, asettings);
+  if (res_code != RES_OK) {
+    fprintf(stderr, "%s\n", thelevel.error);
+    return res_code;
+  }
+  res_code = writeLevelImage(&thelevel.board, asettings->image_path, &hash, thelevel.error);
+  if (res_code != RES_OK) {
+    fprintf(stderr, "%s\n", thelevel.error);
+  } else {
+    printf("%s: %dx%d, %d Futterbrocken, Pruefsumme %016llx\n", asettings->image_path,
+        getLastRowOnBoard(&thelevel.board) + 1, getLastColOnBoard(&thelevel.board) + 1,
+        getNumberOfFoodItems(&thelevel.board), (unsigned long long) hash);
+  }
+  // Tell about parts of the level the worm cannot get to
+  if (res_code == RES_OK && checkLevel(&thelevel.board, &check) == RES_OK) {
+    printf("Erreichbar: %d von %d offenen Zellen, Sackgassen: %d\n",
+        check.reachable_cells, check.open_cells, check.dead_ends);
+    if (check.unreachable_food > 0) {
+      printf("Warnung: %d Futterbrocken nicht erreichbar, der erste bei Zeile %d, Spalte %d\n",
+          check.unreachable_food, check.first_unreachable_food.y, check.first_unreachable_food.x);
+    }
+    releaseLevelCheck(&check);
+  }
+  if (thelevel.scripts.number_of_objects > 0) {
+    printf("Hinweis: die Skripte des Levels werden im Abbild nicht gespeichert\n");
+  }
+  releaseLevel(&thelevel);
+  return res_code;
+}
+
+// Generate a batch of levels and write them as level images
+enum ResCodes generateLevels(struct game_settings* asettings) {
+  int failed;
+
+  if (asettings->rows == 0) {
+    asettings->rows = MIN_NUMBER_OF_ROWS;
+  }
+  if (asettings->cols == 0) {
+    asettings->cols = MIN_NUMBER_OF_COLS;
+  }
+  failed = writeLevelImages(asettings);
+  printf("%d von %d Leveln geschrieben: %s-%llu bis %s-%llu\n",
+      asettings->batch_count - failed, asettings->batch_count,
+      asettings->image_path, (unsigned long long) asettings->seed,
+      asettings->image_path, (unsigned long long) (asettings->seed + asettings->batch_count - 1));
+  return failed == 0 ? RES_OK : RES_FAILED;
+}
+
+// Play the levels in the terminal window
+enum ResCodes playInWindow(struct game_settings* asettings) {
+  enum ResCodes res_code;
+
+  // Here we start
+  initializeCursesApplication();  // Init various settings of our application
+  initializeColors();             // Init colors used in the game
+
+  // Maximal LINES and COLS are set by curses for the current window size.
+  // Note: we do not cope with resizing in this simple examples!
+
+  // Check if the window is large enough to display messages in the message area
+  // a has space for at least MIN_NUMBER_OF_ROWS lines for the worm
+  if ( LINES < ROWS_RESERVED + MIN_NUMBER_OF_ROWS || COLS < MIN_NUMBER_OF_COLS ) {
+    // Since we not even have the space for displaying messages
+    // we print a conventional error message via printf after
+    // the call of cleanupCursesApp()
+    cleanupCursesApp();
+    printf("Das Fenster ist zu klein: wir brauchen mindestens %dx%d\n",
+        MIN_NUMBER_OF_COLS, MIN_NUMBER_OF_ROWS + ROWS_RESERVED);
+    res_code = RES_FAILED;
+  } else {
+    // Without explicit dimensions the board fills the window
+    if (asettings->rows == 0) {
+      asettings->rows = LINES - ROWS_RESERVED;
+    }
+    if (asettings->cols == 0) {
+      asettings->cols = COLS;
+    }
+    res_code = playLevels(asettings);
+    cleanupCursesApp();
+  }
+  return res_code;
+}
+
+// Explain the command line options
+void showUsage(char* progname) {
+  fprintf(stderr, "Aufruf: %s [-r Zeilen] [-c Spalten] [-l Level-Datei] [-g Seed] [-n Anzahl] [-f] [-b] [-w Anzahl] [-t] [-d] [-o Abbild] [-s Anzahl] [-m] [Level-Datei ...]\n", progname);
+  fprintf(stderr, "  -r Zeilen   Anzahl der Zeilen des Spielfelds (Vorgabe: Hoehe des Fensters)\n");
+  fprintf(stderr, "  -c Spalten  Anzahl der Spalten des Spielfelds (Vorgabe: Breite des Fensters)\n");
+  fprintf(stderr, "  -l Datei    Level aus einer Datei lesen (bestimmt auch die Groesse des Spielfelds)\n");
+  fprintf(stderr, "  -g Seed     Level aus dem Seed erzeugen statt des eingebauten Levels\n");
+  fprintf(stderr, "  -f          Gefressenes Futter waechst an zufaelliger Stelle nach\n");
+  fprintf(stderr, "  -b          Ab und zu erscheint fuer kurze Zeit Bonusfutter\n");
+  fprintf(stderr, "  -w Anzahl   So viele vom Rechner gesteuerte Wuermer spielen mit\n");
+  fprintf(stderr, "  -t          Spielfeld als Torus: wer es verlaesst, kommt gegenueber wieder herein\n");
+  fprintf(stderr, "  -d          Der Wurm darf auch schraeg laufen (Tasten a, w, y, d)\n");
+  fprintf(stderr, "  -o Abbild   Level als vorbereitetes Abbild speichern statt zu spielen\n");
+  fprintf(stderr, "  -n Anzahl   So viele Level ab Seed nacheinander spielen;\n");
+  fprintf(stderr, "              mit -o: erzeugen und als Abbild-Seed speichern\n");
+  fprintf(stderr, "  -s Anzahl   Schwarm aus so vielen Wuermern ohne Anzeige laufen lassen und\n");
+  fprintf(stderr, "              Wurm-Schritte pro Sekunde messen (skalar und mit Vektorbefehlen)\n");
+  fprintf(stderr, "  -m          Zugriffe auf die Zellen eines grossen Spielfelds ohne Anzeige messen\n");
+  fprintf(stderr, "  Level-Datei ...  Diese Level nacheinander spielen\n");
+}
+
+int main(int argc, char* argv[]) {
+  int res_code;         // Result code from functions
+  struct game_settings settings; // Settings chosen on the command line
+  int opt;
+  int i;
+
+  // Read the command line before curses takes over the terminal
+  settings.rows = 0;
+  settings.cols = 0;
+  settings.respawn_food = false;
+  settings.fleeting_food = false;
+  settings.steered_worms = 0;
+  settings.torus = false;
+  settings.diagonal = false;
+  settings.level_path = NULL;
+  settings.image_path = NULL;
+  settings.generate = false;
+  settings.seed = 0;
+  settings.batch_count = 0;
+  settings.swarm_size = 0;
+  settings.board_benchmark = false;
+  while ((opt = getopt(argc, argv, "r:c:l:g:fbw:tdo:n:s:mh")) != -1) {
+    switch (opt) {
+      case 'r':
+        settings.rows = atoi(optarg);
+        break;
+      case 'c':
+        settings.cols = atoi(optarg);
+        break;
+      case 'l':
+        settings.level_path = optarg;
+        break;
+      case 'f':
+        settings.respawn_food = true;
+        break;
+      case 'b':
+        settings.fleeting_food = true;
+        break;
+      case 'w':
+        settings.steered_worms = atoi(optarg);
+        if (settings.steered_worms < 0 || settings.steered_worms >= MAX_WORMS) {
+          showUsage(argv[0]);
+          return RES_FAILED;
+        }
+        break;
+      case 't':
+        settings.torus = true;
+        break;
+      case 'd':
+        settings.diagonal = true;
+        break;
+      case 'g':
+        settings.generate = true;
+        settings.seed = strtoull(optarg, NULL, 0);
+        break;
+      case 'o':
+        settings.image_path = optarg;
+        break;
+      case 'n':
+        settings.batch_count = atoi(optarg);
+        if (settings.batch_count <= 0) {
+          showUsage(argv[0]);
+          return RES_FAILED;
+        }
+        break;
+      case 's':
+        settings.swarm_size = atoi(optarg);
+        if (settings.swarm_size <= 0 || settings.swarm_size > MAX_WORMS) {
+          showUsage(argv[0]);
+          return RES_FAILED;
+        }
+        break;
+      case 'm':
+        settings.board_benchmark = true;
+        break;
+      default:
+        showUsage(argv[0]);
+        return RES_FAILED;
+    }
+  }
+  // The remaining arguments are level files played one after another,
+  // following the one given by -l
+  settings.level_paths = malloc((argc + 1) * sizeof(char*));
+  if (settings.level_paths == NULL) {
+    return RES_FAILED;
+  }
+  settings.number_of_level_paths = 0;
+  if (settings.level_path != NULL && optind < argc) {
+    settings.level_paths[settings.number_of_level_paths++] = settings.level_path;
+  }
+  for (i = optind; i < argc; i++) {
+    settings.level_paths[settings.number_of_level_paths++] = argv[i];
+  }
+  if (settings.number_of_level_paths > 0) {
+    settings.level_path = settings.level_paths[0];
+  }
+  if ((settings.rows != 0 && settings.rows < MIN_NUMBER_OF_ROWS)
+      || (settings.cols != 0 && settings.cols < MIN_NUMBER_OF_COLS)
+      || (long long) settings.rows * settings.cols > MAX_NUMBER_OF_CELLS) {
+    fprintf(stderr, "Das Spielfeld muss mindestens %dx%d und hoechstens %d Zellen gross sein\n",
+        MIN_NUMBER_OF_COLS, MIN_NUMBER_OF_ROWS, MAX_NUMBER_OF_CELLS);
+    res_code = RES_FAILED;
+  } else if (settings.swarm_size > 0) {
+    // Generating and converting levels does not need the display,
+    // nor do the benchmarks
+    res_code = runSwarmBenchmark(&settings);
+  } else if (settings.board_benchmark) {
+    res_code = runBoardBenchmark(&settings);
+  } else if (settings.batch_count > 0 && settings.level_path != NULL) {
+    showUsage(argv[0]);
+    res_code = RES_FAILED;
+  } else if (settings.batch_count > 0 && settings.image_path != NULL) {
+    settings.generate = true;
+    res_code = generateLevels(&settings);
+  } else if (settings.image_path != NULL) {
+    res_code = convertLevel(&settings);
+  } else {
+    // Without -o, -n asks for a game of that many generated levels
+    if (settings.batch_count > 0) {
+      settings.generate = true;
+    }
+    res_code = playInWindow(&settings);
+  }
+
+  free(settings.level_paths);
+  return res_code;
+}
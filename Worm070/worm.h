@@ -11,6 +11,9 @@
 #ifndef _WORM_H
 #define _WORM_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 // Result codes of functions
 enum ResCodes {
     RES_OK,
@@ -23,6 +26,7 @@ enum ResCodes {
 #define ROWS_RESERVED 4   // Lines reserved for the status area + 1 for the separator line
 #define MIN_NUMBER_OF_ROWS 26  // The guaranteed number of rows available for the board
 #define MIN_NUMBER_OF_COLS 70  // The guaranteed number of columns available for the board
+#define MAX_NUMBER_OF_CELLS (1 << 28) // Upper bound for rows * cols of a board
 
 // Numbers for color pairs used by curses macro COLOR_PAIR
 enum ColorPairs {
@@ -33,14 +37,17 @@ enum ColorPairs {
     COLP_FOOD_3,
     COLP_BARRIER,
     COLP_WORM_HEAD,
+    COLP_STEERED_WORM,
 };
 
 // Symbols to display
 #define SYMBOL_FREE_CELL  ' '
 #define SYMBOL_BARRIER  '#'
+#define SYMBOL_TORUS_EDGE '~'  // Separator line below a torus board
 #define SYMBOL_FOOD_1   '2'
 #define SYMBOL_FOOD_2   '4'
 #define SYMBOL_FOOD_3   '6'
+#define SYMBOL_FLEETING_FOOD '$'
 #define SYMBOL_WORM_HEAD_ELEMENT '0'
 #define SYMBOL_WORM_INNER_ELEMENT 'o'
 #define SYMBOL_WORM_TAIL_ELEMENT '`'
@@ -54,4 +61,25 @@ enum GameStates {
     WORM_GAME_QUIT,       // User likes to quit
 };
 
+// Settings of the game chosen on the command line
+struct game_settings {
+    int rows;  // Number of rows of the board; 0: as many as the terminal shows
+    int cols;  // Number of columns of the board; 0: as many as the terminal shows
+    bool respawn_food; // Eaten food grows again at a random free cell
+    bool fleeting_food; // Now and then bonus food shows up for a short while
+    int steered_worms;  // Number of worms steered by the computer
+    bool torus;        // Play all levels on a torus board (level files may ask for it, too)
+    bool diagonal;     // Allow diagonal moves in all levels (the same)
+    char* level_path;  // File to read the level from; NULL: built-in level
+    char** level_paths;        // Files of the levels to play one after another
+    int number_of_level_paths; // 0: just one level (or generated levels)
+    char* image_path;  // Write the level as level image to this file instead of playing
+    bool generate;     // Generate the level from seed instead of using the built-in level
+    uint64_t seed;     // Seed of the generated level (the first one in batch mode)
+    int batch_count;   // Number of levels to generate (with image_path) or to play;
+                       // 0: just one
+    int swarm_size;    // Number of worms of the swarm benchmark (see swarm.h); 0: play
+    bool board_benchmark; // Run the board benchmark (see board_bench.h) instead of playing
+};
+
 #endif  // #define _WORM_H
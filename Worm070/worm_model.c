@@ -10,9 +10,16 @@
 // The worm model
 
 #include <curses.h>
+#include <stdlib.h>
+#include <string.h>
 #include "worm.h"
 #include "board_model.h"
+#include "board_planes.h"
 #include "worm_model.h"
+#include "entity.h"
+#if WORM_VECTOR_AIM
+#include <immintrin.h>
+#endif
 
 // ********************************************************************************************
 // Global variables
@@ -20,6 +27,34 @@
 
 enum ColorPairs theworm_wcolor; 
 
+// Offsets of a step in each heading
+static const struct {
+  int dy;
+  int dx;
+} heading_steps[WORM_NUMBER_OF_HEADINGS] = {
+  [WORM_UP]         = { -1,  0 },
+  [WORM_DOWN]       = { +1,  0 },
+  [WORM_LEFT]       = {  0, -1 },
+  [WORM_RIGHT]      = {  0, +1 },
+  [WORM_UP_LEFT]    = { -1, -1 },
+  [WORM_UP_RIGHT]   = { -1, +1 },
+  [WORM_DOWN_LEFT]  = { +1, -1 },
+  [WORM_DOWN_RIGHT] = { +1, +1 },
+};
+
+// For each heading: the set of headings (bits 1 << heading) that would
+// turn the worm back onto its own neck
+static const unsigned int heading_reversals[WORM_NUMBER_OF_HEADINGS] = {
+  [WORM_UP]         = 1 << WORM_DOWN,
+  [WORM_DOWN]       = 1 << WORM_UP,
+  [WORM_LEFT]       = 1 << WORM_RIGHT,
+  [WORM_RIGHT]      = 1 << WORM_LEFT,
+  [WORM_UP_LEFT]    = 1 << WORM_DOWN_RIGHT,
+  [WORM_UP_RIGHT]   = 1 << WORM_DOWN_LEFT,
+  [WORM_DOWN_LEFT]  = 1 << WORM_UP_RIGHT,
+  [WORM_DOWN_RIGHT] = 1 << WORM_UP_LEFT,
+};
+
 
 // *****************************************************
 // Functions concerning the management of the worm data
@@ -28,193 +63,755 @@ enum ColorPairs theworm_wcolor;
 // START WORM_DETAIL
 // The following functions all depend on the model of the worm
 
-// Initialize the worm
-extern enum ResCodes initializeWorm(struct worm* aworm, int len_max,int len_cur, struct pos headpos, enum WormHeading dir, enum ColorPairs color){
-  // Local variables for loops etc.
-  int i;
+// Make the ring buffer of a body hold at least min_capacity elements
+// (runs). The capacity is doubled until it suffices; the elements are kept
+// in order from the tail to the head.
+static enum ResCodes reserveBody(struct worm_body* abody, int min_capacity) {
+  int capacity = abody->capacity;
+  int wrapped;
+#ifdef WORM_BODY_RUNS
+  struct worm_run* elements;
+#else
+  uint32_t* elements;
+#endif
+
+  while (capacity < min_capacity) {
+    capacity *= 2;
+  }
+  if (capacity == abody->capacity) {
+    return RES_OK;
+  }
+  elements = realloc(abody->elements, (size_t) capacity * sizeof(*elements));
+  if (elements == NULL) {
+    return RES_FAILED;
+  }
+  // If the elements wrap around the end of the old buffer, move the
+  // wrapped part behind the others
+  if (abody->tailindex > abody->headindex) {
+    wrapped = abody->headindex + 1;
+    memcpy(elements + abody->capacity, elements, (size_t) wrapped * sizeof(*elements));
+    abody->headindex += abody->capacity;
+  }
+  abody->elements = elements;
+  abody->capacity = capacity;
+  abody->mask = capacity - 1;
+  return RES_OK;
+}
+
+// One step from the cell at index by delta.
+// Only a step into the ring around the board needs a second look: on a
+// torus board it enters the board at the opposite edge.
+static inline int stepCell(struct board* aboard, int index, int delta) {
+  index += delta;
+  if (aboard->torus && getContentOfCell(aboard, index) == BC_OUT_OF_BOUNDS) {
+    index = getWrappedIndex(aboard, index);
+  }
+  return index;
+}
+
+#ifdef WORM_BODY_RUNS
+// The body as a deque of runs.
+// The head run is extended as long as the heading stays the same; a turn
+// starts a new run. The tail run shrinks from its start.
+
+// The element before the head: the head was entered from it with the
+// heading of the head run
+static int getNeckCell(struct board* aboard, struct worm_body* abody, int headcell) {
+  enum WormHeading heading = abody->elements[abody->headindex].heading;
+  return stepCell(aboard, headcell,
+                  -getIndexDelta(aboard, heading_steps[heading].dy, heading_steps[heading].dx));
+}
+
+static int getTailCell(struct worm_body* abody) {
+  return abody->elements[abody->tailindex].start;
+}
 
-  // Initialize last usable index to len_max -1
-  // theworm_maxindex
-  aworm->maxindex = len_max -1;
-  // Current last usable index in array. May grow upto maxindex
-  aworm->cur_lastindex = len_cur -1;
+// Number of elements of the ring buffer in use
+static int getBodySize(struct worm_body* abody) {
+  return ((abody->headindex - abody->tailindex) & abody->mask) + 1;
+}
+
+// Start the body with its head only
+static void startBody(struct worm_body* abody, int headcell, enum WormHeading heading) {
+  abody->headindex = 0;
+  abody->tailindex = 0;
+  abody->elements[0].start = headcell;
+  abody->elements[0].heading = heading;
+  abody->elements[0].length = 1;
+}
 
-  // Initialize headindex
-  aworm->headindex = 0; //Index pointing to head position is set to 0
+// Add a new head element in the given heading.
+// The room for a new run has been made by setWormHeading().
+static void pushHead(struct worm_body* abody, int headcell, enum WormHeading heading) {
+  struct worm_run* run = &abody->elements[abody->headindex];
 
-  // Mark all elements as unused in the arrays of positions
-  // This allows for the effect that the worm appears element by element at the start of each level
-  for(i = 0; i <= aworm->headindex; i++)
-  {
-    aworm->wormpos[i].y  = UNUSED_POS_ELEM;
-    aworm->wormpos[i].x  = UNUSED_POS_ELEM;
+  if (run->length > 0 && run->heading != heading) {
+    abody->headindex = (abody->headindex + 1) & abody->mask;
+    run = &abody->elements[abody->headindex];
+    run->length = 0;
   }
- 
-  //Initialize position of worms head
-  aworm->wormpos[aworm->headindex] = headpos;
+  if (run->length == 0) {
+    run->start = headcell;
+    run->heading = heading;
+  }
+  run->length++;
+}
 
-  //Initialize the heading of the worm
-  setWormHeading(aworm, dir);
+// Remove the tail element. An empty head run is kept for the next head.
+static void popTail(struct board* aboard, struct worm_body* abody) {
+  struct worm_run* run = &abody->elements[abody->tailindex];
 
-  // Initialize color of the worm
-  aworm->wcolor = color;
+  run->length--;
+  if (run->length > 0) {
+    run->start = stepCell(aboard, run->start,
+        getIndexDelta(aboard, heading_steps[run->heading].dy, heading_steps[run->heading].dx));
+  } else if (abody->tailindex != abody->headindex) {
+    abody->tailindex = (abody->tailindex + 1) & abody->mask;
+  }
+}
+#else
+// The body as one cell per element
+
+static int getNeckCell(struct board* aboard, struct worm_body* abody, int headcell) {
+  return abody->elements[(abody->headindex - 1) & abody->mask];
+}
+
+static int getTailCell(struct worm_body* abody) {
+  return abody->elements[abody->tailindex];
+}
+
+static void startBody(struct worm_body* abody, int headcell, enum WormHeading heading) {
+  abody->headindex = 0;
+  abody->tailindex = 0;
+  abody->elements[0] = headcell;
+}
+
+// Add a new head element; growWorm() has made room for all elements to come
+static void pushHead(struct worm_body* abody, int headcell, enum WormHeading heading) {
+  abody->headindex = (abody->headindex + 1) & abody->mask;
+  abody->elements[abody->headindex] = headcell;
+}
+
+static void popTail(struct board* aboard, struct worm_body* abody) {
+  abody->tailindex = (abody->tailindex + 1) & abody->mask;
+}
+#endif
+
+// Get the arrays for up to capacity worms in one block.
+// The caller must release the set by releaseWorms().
+enum ResCodes initializeWorms(struct worm_set* aset, struct board* aboard, int capacity) {
+  size_t words = (size_t) capacity * sizeof(uint32_t);
+  size_t bytes = (size_t) capacity * sizeof(uint8_t);
 
+  size_t cells = (size_t) (getLastRowOnBoard(aboard) + 3) * getIndexDelta(aboard, 1, 0);
+  char* block;
+
+  if (capacity > MAX_WORMS) {
+    return RES_FAILED;
+  }
+  block = malloc(6 * words + 6 * bytes + (size_t) capacity * sizeof(struct worm_body));
+  if (block == NULL) {
+    return RES_FAILED;
+  }
+  // No cell has an owner yet
+  aset->owners = malloc(cells * sizeof(uint16_t));
+  if (aset->owners == NULL) {
+    free(block);
+    return RES_FAILED;
+  }
+  memset(aset->owners, 0xff, cells * sizeof(uint16_t));
+  // The bodies come first: they need the strongest alignment
+  aset->bodies = (struct worm_body*) block;
+  block += (size_t) capacity * sizeof(struct worm_body);
+  aset->head = (uint32_t*) block;
+  aset->target = (uint32_t*) (block + words);
+  aset->delta = (int*) (block + 2 * words);
+  aset->length = (int*) (block + 3 * words);
+  aset->pending_growth = (int*) (block + 4 * words);
+  aset->kills = (int*) (block + 5 * words);
+  block += 6 * words;
+  aset->heading = (uint8_t*) block;
+  aset->state = (uint8_t*) (block + bytes);
+  aset->color = (uint8_t*) (block + 2 * bytes);
+  aset->steered = (uint8_t*) (block + 3 * bytes);
+  aset->hit = (uint16_t*) (block + 4 * bytes);
+
+  aset->count = 0;
+  aset->capacity = capacity;
+  aset->stride = getIndexDelta(aboard, 1, 0);
+  aset->max_length = (getLastRowOnBoard(aboard) + 1) * (getLastColOnBoard(aboard) + 1);
+  aset->vector_aim = WORM_VECTOR_AIM;
+  aset->changed = NULL;
+  aset->number_changed = 0;
+  aset->changed_capacity = 0;
   return RES_OK;
 }
 
-// Show the worms's elements on the display
-// Simple version
-extern void showWorm(struct board* aboard, struct worm* aworm) {
-  // Draw headelement with headindex
-  placeItem(aboard, aworm->wormpos[aworm->headindex].y, aworm->wormpos[aworm->headindex].x, BC_USED_BY_WORM, SYMBOL_WORM_HEAD_ELEMENT, COLP_WORM_HEAD);
-  // Calculate inner Elements
-  int i = (aworm->headindex + 1) % (aworm-> cur_lastindex + 1);
-  if(aworm->wormpos[i].y == UNUSED_POS_ELEM && i == 1)
-    return;
-  if(aworm->wormpos[i].y == UNUSED_POS_ELEM && i == 2){
-    placeItem(aboard, aworm->wormpos[0].y, aworm->wormpos[0].x, BC_USED_BY_WORM, SYMBOL_WORM_INNER_ELEMENT, aworm->wcolor);
-    return;
+// Free the bodies and the arrays of the set
+void releaseWorms(struct worm_set* aset) {
+  int i;
+
+  for (i = 0; i < aset->count; i++) {
+    free(aset->bodies[i].elements);
   }
-  if (aworm->wormpos[i].y == UNUSED_POS_ELEM)
-    i = 0;
-  placeItem(aboard, aworm->wormpos[i].y, aworm->wormpos[i].x, BC_USED_BY_WORM, SYMBOL_WORM_TAIL_ELEMENT, aworm->wcolor);
-  i = (i + 1) % (aworm-> cur_lastindex + 1);
-  while(i != aworm->headindex){
-    if (aworm->wormpos[i].y == UNUSED_POS_ELEM){
-      i = 0;
-      continue;
+  free(aset->bodies);
+  free(aset->changed);
+  free(aset->owners);
+  aset->bodies = NULL;
+  aset->owners = NULL;
+  aset->changed = NULL;
+  aset->count = 0;
+}
+
+// Add a worm to the set and put its head onto the board.
+// The worm starts with its head only and appears element by element
+// until it has len_cur elements; it may grow until it fills the board.
+// Returns the number of the worm or -1 if there is no room for it, be it
+// in the set, in memory or on the board: the head needs a free cell.
+int addWorm(struct worm_set* aset, struct board* aboard, int len_cur, struct pos headpos,
+            enum WormHeading dir, enum ColorPairs color, bool steered) {
+  int worm = aset->count;
+  struct worm_body* abody = &aset->bodies[worm];
+  int headcell = getCellIndex(aboard, headpos.y, headpos.x);
+
+  if (worm == aset->capacity || getContentOfCell(aboard, headcell) != BC_FREE_CELL) {
+    return -1;
+  }
+  // Get a small ring buffer; it grows with the worm
+  abody->elements = NULL;
+  abody->capacity = 1;
+  abody->mask = 0;
+  abody->headindex = 0;
+  abody->tailindex = 0;
+  if (reserveBody(abody, len_cur > WORM_INITIAL_CAPACITY ? len_cur : WORM_INITIAL_CAPACITY) != RES_OK) {
+    return -1;
+  }
+  startBody(abody, headcell, dir);
+  setCellContent(aboard, headpos.y, headpos.x, BC_USED_BY_WORM);
+  aset->owners[headcell] = worm;
+
+  aset->head[worm] = headcell;
+  aset->target[worm] = headcell;
+  aset->heading[worm] = dir;
+  aset->delta[worm] = getIndexDelta(aboard, heading_steps[dir].dy, heading_steps[dir].dx);
+  aset->state[worm] = WORM_GAME_ONGOING;
+  aset->length[worm] = 1;
+  aset->pending_growth[worm] = len_cur - 1;
+  aset->color[worm] = color;
+  aset->steered[worm] = steered;
+  aset->hit[worm] = WORM_NO_OWNER;
+  aset->kills[worm] = 0;
+  aset->count++;
+  return worm;
+}
+
+// Remember a cell freed by the current step
+static void addChangedCell(struct worm_set* aset, int index) {
+  int capacity;
+  int* changed;
+
+  if (aset->number_changed == aset->changed_capacity) {
+    capacity = aset->changed_capacity > 0 ? 2 * aset->changed_capacity : WORM_INITIAL_CAPACITY;
+    changed = realloc(aset->changed, (size_t) capacity * sizeof(int));
+    if (changed == NULL) {
+      return;  // The cell is not redrawn; the board itself is right
     }
-    placeItem(aboard, aworm->wormpos[i].y, aworm->wormpos[i].x, BC_USED_BY_WORM, SYMBOL_WORM_INNER_ELEMENT, aworm->wcolor);
-    i = (i + 1) % (aworm-> cur_lastindex + 1);
+    aset->changed = changed;
+    aset->changed_capacity = capacity;
   }
+  aset->changed[aset->number_changed++] = index;
 }
 
-void cleanWormTail(struct board* aboard, struct worm* aworm){
-  int max_len = aworm->cur_lastindex + 1;
+// Free the cell of a tail element
+static void clearTailCell(struct worm_set* aset, struct board* aboard, int cell) {
+  setContentOfCell(aboard, cell, BC_FREE_CELL);
+  aset->owners[cell] = WORM_NO_OWNER;
+  addChangedCell(aset, cell);
+}
 
-  // compute tailindex
-  int tailindex = (aworm->headindex + 1) % max_len;
+// Take a dead worm off the board
+static void removeWormBody(struct worm_set* aset, struct board* aboard, int worm) {
+  struct worm_body* abody = &aset->bodies[worm];
 
-  // Check the array of worm elements
-  // Is the array element at tailindex already in use?
-  if(aworm->wormpos[tailindex].y != UNUSED_POS_ELEM)
-  {
-    //YES: place a SYMBOL_FREE_CELL at the tail's position
-    placeItem(aboard, aworm->wormpos[tailindex].y,aworm->wormpos[tailindex].x,BC_FREE_CELL,SYMBOL_FREE_CELL,COLP_FREE_CELL);
+  while (aset->length[worm] > 0) {
+    clearTailCell(aset, aboard, getTailCell(abody));
+    popTail(aboard, abody);
+    aset->length[worm]--;
   }
 }
 
-void moveWorm(struct board* aboard, struct worm* aworm, enum GameStates* agame_state) {
-  // Compute and store new head position according to current heading.
-  struct pos headpos;
+// Note that the head of a worm ran into the given worm
+static void noteHit(struct worm_set* aset, int worm, int owner) {
+  aset->hit[worm] = owner;
+  if (owner != WORM_NO_OWNER && owner != worm) {
+    aset->kills[owner]++;
+  }
+}
 
-  headpos.y = aworm->wormpos[aworm->headindex].y + aworm->dy;
-  headpos.x = aworm->wormpos[aworm->headindex].x + aworm->dx;
+// The two cells a diagonal step passes between: beside the head in the
+// direction of the step, and ahead of it along the other axis.
+// If both are blocked by barriers or worms, the step fails like a step
+// into one of them. Returns the state of the worm after the step.
+static enum GameStates checkSqueeze(struct worm_set* aset, struct board* aboard, int worm) {
+  int head = aset->head[worm];
+  int dx = heading_steps[aset->heading[worm]].dx;
+  int beside = stepCell(aboard, head, dx);
+  int ahead = stepCell(aboard, head, aset->delta[worm] - dx);
+  enum BoardCodes beside_code = getContentOfCell(aboard, beside);
+  enum BoardCodes ahead_code = getContentOfCell(aboard, ahead);
+
+  if ((beside_code != BC_BARRIER && beside_code != BC_USED_BY_WORM)
+      || (ahead_code != BC_BARRIER && ahead_code != BC_USED_BY_WORM)) {
+    return WORM_GAME_ONGOING;
+  }
+  if (beside_code == BC_BARRIER || ahead_code == BC_BARRIER) {
+    return WORM_CRASH;
+  }
+  noteHit(aset, worm, aset->owners[beside]);
+  return WORM_CROSSING;
+}
+
+// Find out what the target cell does to the head of a worm.
+// Only the board as left by the tails is looked at: no head has moved yet.
+static void aimHead(struct worm_set* aset, struct board* aboard, int worm) {
+  int headcell = aset->target[worm];
+  const struct entity_behaviour* behaviour;
+
+  // On a torus board the head leaves at one edge and enters at the other
+  if (aboard->torus && getContentOfCell(aboard, headcell) == BC_OUT_OF_BOUNDS) {
+    headcell = getWrappedIndex(aboard, headcell);
+    aset->target[worm] = headcell;
+  }
+
+  // A diagonal step must not squeeze through between two occupied cells
+  if (aset->heading[worm] >= WORM_UP_LEFT) {
+    aset->state[worm] = checkSqueeze(aset, aboard, worm);
+    if (aset->state[worm] != WORM_GAME_ONGOING) {
+      return;
+    }
+  }
 
   // Check if we would hit something (for good or bad) or are going to leave
-  // the display if we move the worm's head according to worm's last
-  // direction. We are not allowed to leave the display's window.
-  if (headpos.x < 0) {
-    *agame_state = WORM_OUT_OF_BOUNDS;
-  } else if (headpos.x > getLastColOnBoard(aboard) ) { 
-    *agame_state = WORM_OUT_OF_BOUNDS;
-  } else if (headpos.y < 0) {  
-    *agame_state = WORM_OUT_OF_BOUNDS;
-  } else if (headpos.y > getLastRowOnBoard(aboard) ) {
-    *agame_state = WORM_OUT_OF_BOUNDS;
+  // the board. The board is surrounded by a ring of BC_OUT_OF_BOUNDS cells.
+  // Thus, a single look at the new cell also tells us whether we stay
+  // within bounds. On a torus board the head has been wrapped and never
+  // stays in the ring.
+  // What the entity in the cell does to the worm is given by the table of
+  // entity behaviours (see entity.c): hitting food is good, hitting
+  // barriers or worm elements is bad.
+  behaviour = &entity_behaviours[getEntityTypeOfCell(aboard, headcell)];
+  aset->state[worm] = behaviour->on_hit;
+  if (behaviour->code == BC_USED_BY_WORM) {
+    noteHit(aset, worm, aset->owners[headcell]);
+  }
+}
+
+#if WORM_VECTOR_AIM
+// Aim the heads of eight worms at a time, like aimHead() does.
+// The cells ahead are fetched by one gather. It reads four bytes per cell;
+// this stays within the storage of the board since the bit planes follow
+// the cells (see layoutBoardStorage()). Only the lowest byte is used.
+// Worms that need a closer look (diagonal steps, wrapping on a torus,
+// running into a worm) are handed to aimHead().
+// Returns the number of worms done; the rest is left to the scalar code.
+static int aimHeadsVector(struct worm_set* aset, struct board* aboard) {
+  int on_hit[1 << (8 - BC_TYPE_SHIFT)]; // What each type does to a head
+  int hit_lanes[8];
+  int n = aset->count & ~7;
+  const __m256i byte_mask = _mm256_set1_epi32(0xff);
+  const __m256i code_mask = _mm256_set1_epi32(BC_CODE_MASK);
+  const __m256i ongoing = _mm256_set1_epi32(WORM_GAME_ONGOING);
+  const __m256i last_straight = _mm256_set1_epi32(WORM_UP_LEFT - 1);
+  const __m256i worm_code = _mm256_set1_epi32(BC_USED_BY_WORM);
+  const __m256i wrap_code = _mm256_set1_epi32(aboard->torus ? BC_OUT_OF_BOUNDS : -1);
+  __m256i target;
+  __m256i cell;
+  __m256i hit;
+  __m256i alive;
+  __m256i closer;
+  unsigned int closer_lanes;
+  unsigned int dying_lanes;
+  int t;
+  int i;
+  int k;
+
+  for (t = 0; t < (int) (sizeof(on_hit) / sizeof(on_hit[0])); t++) {
+    on_hit[t] = t < ET_NUMBER_OF_TYPES ? entity_behaviours[t].on_hit : WORM_CRASH;
+  }
+  for (i = 0; i < n; i += 8) {
+    target = _mm256_add_epi32(_mm256_loadu_si256((__m256i*) &aset->head[i]),
+                              _mm256_loadu_si256((__m256i*) &aset->delta[i]));
+    _mm256_storeu_si256((__m256i*) &aset->target[i], target);
+
+    cell = _mm256_and_si256(
+        _mm256_i32gather_epi32((const int*) aboard->cells, target, 1), byte_mask);
+    hit = _mm256_i32gather_epi32(on_hit, _mm256_srli_epi32(cell, BC_TYPE_SHIFT), 4);
+    cell = _mm256_and_si256(cell, code_mask);
+
+    alive = _mm256_cmpeq_epi32(ongoing,
+        _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*) &aset->state[i])));
+    closer = _mm256_or_si256(
+        _mm256_cmpgt_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*) &aset->heading[i])),
+                           last_straight),
+        _mm256_or_si256(_mm256_cmpeq_epi32(cell, worm_code), _mm256_cmpeq_epi32(cell, wrap_code)));
+    closer_lanes = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(alive, closer)));
+    dying_lanes = _mm256_movemask_ps(_mm256_castsi256_ps(
+        _mm256_andnot_si256(_mm256_or_si256(closer, _mm256_cmpeq_epi32(hit, ongoing)), alive)));
+
+    // Most worms just go on; the others are few
+    if ((closer_lanes | dying_lanes) == 0) {
+      continue;
+    }
+    _mm256_storeu_si256((__m256i*) hit_lanes, hit);
+    for (k = 0; k < 8; k++) {
+      if (closer_lanes & (1u << k)) {
+        aimHead(aset, aboard, i + k);
+      } else if (dying_lanes & (1u << k)) {
+        aset->state[i + k] = hit_lanes[k];
+      }
+    }
+  }
+  return n;
+}
+#endif
+
+// Of two worms heading for the same cell the longer one gets it.
+// The worm number only picks a claimant among worms of equal length;
+// they all perish later on (see stepWorms()).
+static bool isStronger(struct worm_set* aset, int worm, int other) {
+  return aset->length[worm] > aset->length[other]
+      || (aset->length[worm] == aset->length[other] && worm < other);
+}
+
+// Move the head of a worm onto its target cell, which it has won
+static void moveHead(struct worm_set* aset, struct board* aboard, int worm) {
+  int headcell = aset->target[worm];
+  const struct entity_behaviour* behaviour =
+      &entity_behaviours[getEntityTypeOfCell(aboard, headcell)];
+
+  // Eaten food leaves the board's food counters right here
+  setContentOfCell(aboard, headcell, BC_USED_BY_WORM);
+  pushHead(&aset->bodies[worm], headcell, aset->heading[worm]);
+  aset->head[worm] = headcell;
+  aset->length[worm]++;
+
+  // Grow worm according to food item digested.
+  // The new head is counted already: the ring buffer must hold the body
+  // it ends up with.
+  if (behaviour->growth > 0) {
+    growWorm(aset, worm, behaviour->growth);
+  }
+}
+
+// Move all living worms by one step.
+// The board is updated, the display is not: see showWorms().
+// All worms move at the same time. The outcome does not depend on the
+// order of the worms in the set, which keeps replays and networked games
+// in step:
+//   1. All tails move. A head may enter the cell a tail is leaving.
+//   2. All heads look at their target cells on the board left by step 1.
+//      A worm running into a barrier or a body dies, even if that body
+//      belongs to a worm that dies in the same tick.
+//   3. Heads heading for the same cell (say the same food) contend for it.
+//      The longest worm wins and the others cross into it. If the longest
+//      worms are of equal length, all of them perish; nobody eats and
+//      nobody scores a kill.
+//   4. The winning heads move. Worms steered by the computer that died are
+//      taken off the board; the user's worm stays where it is.
+// The owner plane serves as a hash table for step 3: a target cell is
+// free or food, thus it has no owner yet and can hold the claimant.
+void stepWorms(struct worm_set* aset, struct board* aboard) {
+  int n = aset->count;
+  int claimant;
+  int i;
+
+  aset->number_changed = 0;
+
+  // Tails first. A growing worm keeps its tail.
+  for (i = 0; i < n; i++) {
+    if (aset->state[i] != WORM_GAME_ONGOING) {
+      continue;
+    }
+    if (aset->pending_growth[i] > 0) {
+      aset->pending_growth[i]--;
+      continue;
+    }
+    clearTailCell(aset, aboard, getTailCell(&aset->bodies[i]));
+    popTail(aboard, &aset->bodies[i]);
+    aset->length[i]--;
+  }
+
+  // The cells all heads are heading for and what they hold
+  i = 0;
+#if WORM_VECTOR_AIM
+  if (aset->vector_aim) {
+    i = aimHeadsVector(aset, aboard);
+  }
+#endif
+  for (; i < n; i++) {
+    aset->target[i] = aset->head[i] + aset->delta[i];
+    if (aset->state[i] == WORM_GAME_ONGOING) {
+      aimHead(aset, aboard, i);
+    }
+  }
+
+  // Claim the target cells: the strongest worm is left in the cell
+  for (i = 0; i < n; i++) {
+    if (aset->state[i] != WORM_GAME_ONGOING) {
+      continue;
+    }
+    claimant = aset->owners[aset->target[i]];
+    if (claimant == WORM_NO_OWNER || isStronger(aset, i, claimant)) {
+      aset->owners[aset->target[i]] = i;
+    }
+  }
+
+  // The losers cross into the winner. A loser as long as the winner takes
+  // it along; it notes the lowest such loser as the worm it hit. Such a tie
+  // is no kill for either of them.
+  for (i = 0; i < n; i++) {
+    if (aset->state[i] != WORM_GAME_ONGOING) {
+      continue;
+    }
+    claimant = aset->owners[aset->target[i]];
+    if (claimant == i) {
+      continue;
+    }
+    aset->state[i] = WORM_CROSSING;
+    if (aset->length[i] != aset->length[claimant]) {
+      noteHit(aset, i, claimant);
+      continue;
+    }
+    aset->hit[i] = claimant;
+    if (i < aset->hit[claimant]) {
+      aset->hit[claimant] = i;
+    }
+  }
+
+  // Move the winners
+  for (i = 0; i < n; i++) {
+    if (aset->state[i] != WORM_GAME_ONGOING) {
+      continue;
+    }
+    if (aset->hit[i] != WORM_NO_OWNER) {
+      // Tied with another worm: nobody gets the cell
+      aset->state[i] = WORM_CROSSING;
+      aset->owners[aset->target[i]] = WORM_NO_OWNER;
+      continue;
+    }
+    moveHead(aset, aboard, i);
+  }
+
+  // Clear away the dead
+  for (i = 0; i < n; i++) {
+    if (aset->state[i] != WORM_GAME_ONGOING && aset->steered[i] && aset->length[i] > 0) {
+      removeWormBody(aset, aboard, i);
+    }
+  }
+}
+
+// Show the changes of the last step on the display.
+// Only the elements of a worm that changed with a step are drawn: the new
+// head, the former head (now an inner element) and the tail.
+void showWorms(struct worm_set* aset, struct board* aboard) {
+  struct worm_body* abody;
+  int i;
+
+  redrawCells(aboard, aset->changed, aset->number_changed);
+  for (i = 0; i < aset->count; i++) {
+    if (aset->length[i] == 0) {
+      continue;
+    }
+    abody = &aset->bodies[i];
+    drawCell(aboard, aset->head[i], SYMBOL_WORM_HEAD_ELEMENT, COLP_WORM_HEAD);
+    if (aset->length[i] < 2) {
+      continue;
+    }
+    drawCell(aboard, getNeckCell(aboard, abody, aset->head[i]), SYMBOL_WORM_INNER_ELEMENT, aset->color[i]);
+    drawCell(aboard, getTailCell(abody), SYMBOL_WORM_TAIL_ELEMENT, aset->color[i]);
+  }
+}
+
+// Can worm i take a step in heading dir without coming to harm?
+static bool isSafeHeading(struct worm_set* aset, struct board* aboard, int worm, int dir) {
+  int cell = stepCell(aboard, aset->head[worm],
+                      getIndexDelta(aboard, heading_steps[dir].dy, heading_steps[dir].dx));
+
+  return entity_behaviours[getEntityTypeOfCell(aboard, cell)].on_hit == WORM_GAME_ONGOING;
+}
+
+// The heading with the step (dy,dx), dy and dx from the set {-1,0,+1}
+static int findHeading(int dy, int dx) {
+  int dir;
+
+  for (dir = 0; dir < WORM_NUMBER_OF_HEADINGS; dir++) {
+    if (heading_steps[dir].dy == dy && heading_steps[dir].dx == dx) {
+      break;
+    }
+  }
+  return dir;
+}
+
+// Turn a worm steered by the computer towards the nearest food item within
+// WORM_SCENT_RADIUS. The worm takes the diagonal if the board allows it,
+// otherwise the axis with the longer way first. It does not turn back onto
+// its neck nor into anything bad.
+// Returns false if there is no such food item or no safe heading towards it.
+static bool steerTowardsFood(struct worm_set* aset, struct board* aboard, int worm) {
+  struct pos head = getCellPosition(aboard, aset->head[worm]);
+  struct pos food;
+  int rows = aboard->last_row + 1;
+  int cols = aboard->last_col + 1;
+  int candidates[3];
+  int number_of_candidates = 0;
+  int dy;
+  int dx;
+  int sy;
+  int sx;
+  int k;
+
+  if (!findNearestFood(aboard, head, WORM_SCENT_RADIUS, &food)) {
+    return false;
+  }
+  dy = food.y - head.y;
+  dx = food.x - head.x;
+  // On a torus the way round the edge may be the shorter one
+  if (aboard->torus) {
+    if (2 * dy > rows) {
+      dy -= rows;
+    } else if (2 * dy < -rows) {
+      dy += rows;
+    }
+    if (2 * dx > cols) {
+      dx -= cols;
+    } else if (2 * dx < -cols) {
+      dx += cols;
+    }
+  }
+  sy = (dy > 0) - (dy < 0);
+  sx = (dx > 0) - (dx < 0);
+  if (sy != 0 && sx != 0 && isBoardDiagonal(aboard)) {
+    candidates[number_of_candidates++] = findHeading(sy, sx);
+  }
+  if (abs(dy) >= abs(dx)) {
+    candidates[number_of_candidates++] = findHeading(sy, 0);
+    if (sx != 0) {
+      candidates[number_of_candidates++] = findHeading(0, sx);
+    }
   } else {
-    // We will stay within bounds.
-    // Check if the worm's head hits any items at the new position on the board,
-    // Hitting food is good, hitting barriers or worm elements is bad.
-    switch(getContentAt(aboard,headpos)){
-      case BC_FOOD_1:
-        *agame_state = WORM_GAME_ONGOING;
-        // Grow worm according to food item digested
-        growWorm(aworm, BONUS_1);
-        decrementNumberOfFoodItems(aboard);
-        break;
-      case BC_FOOD_2:
-        *agame_state = WORM_GAME_ONGOING;
-        // Grow worm according to food item digested
-        growWorm(aworm, BONUS_2);
-        decrementNumberOfFoodItems(aboard);
-        break;
-      case BC_FOOD_3:
-        *agame_state = WORM_GAME_ONGOING;
-        // Grow worm according to food item digested
-        growWorm(aworm, BONUS_3);
-        decrementNumberOfFoodItems(aboard);
-        break;
-      case BC_BARRIER:
-        // No good
-        *agame_state = WORM_CRASH;
-        break;
-      case BC_USED_BY_WORM:
-        // No good
-        *agame_state = WORM_CROSSING;
-        break;
-      default:
-        // Without default case we get warning.
-        {;} // Do nothing. C syntax dictates some statement here.
-    }
-  }
-
-  // Check if status of *agame_state
-  // Go on if nothing bad happened
-  if(*agame_state == WORM_GAME_ONGOING)
-  {
-    // So all is well: we did not hit anything bad and did not leave the
-    // window. --> Update the worm structure.
-    // Increment theworm_headindex
-    // Go round if end of worm is reached (ring buffer)
-    aworm->headindex++;
-    if (aworm->headindex > aworm->cur_lastindex){
-      aworm->headindex = 0;
-    }
-    // Store new coordinates of head element in worm structure
-    aworm->wormpos[aworm->headindex] = headpos;
+    candidates[number_of_candidates++] = findHeading(0, sx);
+    if (sy != 0) {
+      candidates[number_of_candidates++] = findHeading(sy, 0);
+    }
+  }
+  for (k = 0; k < number_of_candidates; k++) {
+    if (!(heading_reversals[aset->heading[worm]] & (1 << candidates[k]))
+        && isSafeHeading(aset, aboard, worm, candidates[k])) {
+      setWormHeading(aset, worm, candidates[k]);
+      if (aset->heading[worm] == candidates[k]) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Pick new headings for the worms steered by the computer.
+// Such a worm heads for food it scents nearby. Otherwise it keeps its
+// heading until it would run into something bad; now and then it turns
+// for no reason.
+void steerWorms(struct worm_set* aset, struct board* aboard, struct rng* arng) {
+  int number_of_headings = isBoardDiagonal(aboard) ? WORM_NUMBER_OF_HEADINGS : WORM_UP_LEFT;
+  int first;
+  int dir;
+  int k;
+  int i;
+
+  for (i = 0; i < aset->count; i++) {
+    if (!aset->steered[i] || aset->state[i] != WORM_GAME_ONGOING) {
+      continue;
+    }
+    if (steerTowardsFood(aset, aboard, i)) {
+      continue;
+    }
+    if (isSafeHeading(aset, aboard, i, aset->heading[i])
+        && nextRandomBelow(arng, WORM_TURN_CHANCE) != 0) {
+      continue;
+    }
+    first = nextRandomBelow(arng, number_of_headings);
+    for (k = 0; k < number_of_headings; k++) {
+      dir = (first + k) % number_of_headings;
+      if (isSafeHeading(aset, aboard, i, dir)) {
+        setWormHeading(aset, i, dir);
+        if (aset->heading[i] == dir) {
+          break;
+        }
+      }
+    }
   }
 }
 
 // Grow grow grow grow grow grow grow grow grow grow
-void growWorm(struct worm* aworm, enum Boni growth){
+// The worm grows by one element with each of the next steps.
+void growWorm(struct worm_set* aset, int worm, enum Boni growth){
+  int room = aset->max_length - aset->length[worm] - aset->pending_growth[worm];
+
   // Play it safe and inhibit surpassing the bound
-  if(aworm->cur_lastindex + growth <= aworm->maxindex){
-    aworm->cur_lastindex += growth;
-  } else {
-    aworm->cur_lastindex = aworm->maxindex;
+  if (growth > room) {
+    growth = room;
   }
+#ifndef WORM_BODY_RUNS
+  // Make room in the ring buffer; without memory the worm stops growing
+  if (reserveBody(&aset->bodies[worm],
+                  aset->length[worm] + aset->pending_growth[worm] + growth) != RES_OK) {
+    growth = aset->bodies[worm].capacity - aset->length[worm] - aset->pending_growth[worm];
+  }
+#endif
+  aset->pending_growth[worm] += growth;
 }
 
 // Setters
-void setWormHeading(struct worm* aworm, enum WormHeading dir) {
-  switch(dir) {
-    case WORM_UP :// User wants up
-      aworm->dx=0;
-      aworm->dy=-1;
-      break;
-    case WORM_DOWN :// User wants down
-      aworm->dx=0;
-      aworm->dy=+1;
-      break;
-    case WORM_LEFT :// User wants left
-      aworm->dx=-1;
-      aworm->dy=0;
-      break;
-    case WORM_RIGHT :// User wants right
-      aworm->dx=+1;
-      aworm->dy=0;
-      break;
+// Turn the worm; turning straight back is ignored
+void setWormHeading(struct worm_set* aset, int worm, enum WormHeading dir) {
+  if (heading_reversals[aset->heading[worm]] & (1 << dir)) {
+    return;
   }
-} 
+#ifdef WORM_BODY_RUNS
+  // The next step may start a new run; without memory the worm goes on straight
+  if (dir != aset->heading[worm]
+      && reserveBody(&aset->bodies[worm], getBodySize(&aset->bodies[worm]) + 1) != RES_OK) {
+    return;
+  }
+#endif
+  aset->heading[worm] = dir;
+  aset->delta[worm] = heading_steps[dir].dy * aset->stride + heading_steps[dir].dx;
+}
 
 // Getters
-struct pos getWormHeadPos(struct worm* aworm){
+int getWormHeadCell(struct worm_set* aset, int worm){
+  return aset->head[worm];
+}
+
+struct pos getWormHeadPos(struct worm_set* aset, struct board* aboard, int worm){
   // Structures are passed by value!
   // -> we return a copy here
-  return aworm->wormpos[aworm->headindex];
+  return getCellPosition(aboard, aset->head[worm]);
+}
+
+int getWormLength(struct worm_set* aset, int worm){
+  return aset->length[worm];
+}
+
+enum GameStates getWormState(struct worm_set* aset, int worm){
+  return aset->state[worm];
+}
+
+// The worm whose body the head of the given worm ran into (possibly its
+// own) or WORM_NO_OWNER
+int getWormHit(struct worm_set* aset, int worm){
+  return aset->hit[worm];
 }
 
-int getWormLength(struct worm* aworm){
-  return aworm->cur_lastindex;
+int getWormKills(struct worm_set* aset, int worm){
+  return aset->kills[worm];
 }
@@ -13,64 +13,150 @@
 #define _WORM_MODEL_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "worm.h"
 #include "board_model.h"
-
-// Codes for the array of positions
-#define UNUSED_POS_ELEM -1  // Unused element in the worm arrays of positions
+#include "rng.h"
 
 // Dimensions and bounds
-#define WORM_LENGTH (MIN_NUMBER_OF_ROWS * MIN_NUMBER_OF_COLS) // Max length of a worm
-#define WORM_INITIAL_LENGTH 4  // Initial length of the user's worm
+#define WORM_INITIAL_LENGTH 4    // Initial length of the user's worm
+#define WORM_INITIAL_CAPACITY 8  // Smallest ring buffer of a worm (power of two)
+#define USER_WORM 0              // Number of the user's worm in the set of worms
+#define WORM_TURN_CHANCE 16      // A steered worm turns for no reason once in so many steps
+#define WORM_SCENT_RADIUS 8      // A steered worm heads for food at most so many cells away
+#define MAX_WORMS 65535          // Worms are told apart by 16-bit numbers
+#define WORM_NO_OWNER 0xffff     // Owner of a cell not used by any worm
+
+// The heads of eight worms at a time are aimed with AVX2 instructions if
+// the compiler may use them (-mavx2, see Makefile). The tiled layout of the
+// board always needs the scalar code. Only the aiming is vectorized: tails,
+// claims, head moves and state changes write to scattered cells and stay
+// scalar, so the whole step gains little (see the swarm benchmark, -s).
+#if defined(__AVX2__) && !defined(BOARD_LAYOUT_TILED)
+#define WORM_VECTOR_AIM 1
+#else
+#define WORM_VECTOR_AIM 0
+#endif
 
 // Boni for eating food
 enum Boni {
     BONUS_1 = 2, // additional length for worm when consuming food of type 1
     BONUS_2 = 4, // additional length for worm when consuming food of type 2
     BONUS_3 = 6, // additional length for worm when consuming food of type 3
+    BONUS_FLEETING = 10, // additional length for worm when consuming fleeting food
 };
 
-// A worm structure
-struct worm
-{
-    int cur_lastindex; // The current last index in the array of worm's element positions
-    int maxindex;      // Last usable index into the array pointed to by wormpos
-
-    int headindex;     // An index into the array for the head position of the worm
-    // 0 <= headindex <= maxindex
-
-    struct pos wormpos[WORM_LENGTH]; // Array of x,y positions of all elements of the worm
-
-    // The current heading of the worm
-    // These are offsets from the set {-1,0,+1}
-    int dx;
-    int dy;
-
-    // Color of the worm
-    enum ColorPairs wcolor; 
-};
-
+// Headings of a worm; the diagonal ones are only allowed on boards
+// that permit diagonal moves (see isBoardDiagonal())
 enum WormHeading {
     WORM_UP,
     WORM_DOWN,
     WORM_LEFT,
-    WORM_RIGHT
+    WORM_RIGHT,
+    WORM_UP_LEFT,
+    WORM_UP_RIGHT,
+    WORM_DOWN_LEFT,
+    WORM_DOWN_RIGHT,
+    WORM_NUMBER_OF_HEADINGS
+};
+
+#ifdef WORM_BODY_RUNS
+// With WORM_BODY_RUNS defined (see Makefile) the body of a worm is kept as
+// straight runs of elements instead of one position per element.
+// A worm needs one run per turn it made, no matter how long it is.
+struct worm_run {
+    uint32_t start;   // Cell of the element of the run nearest to the tail
+    uint8_t heading;  // Step from one element of the run to the next (enum WormHeading)
+    int length;       // Number of elements in the run
+};
+#endif
+
+// The body of a worm is kept in a ring buffer on the heap: one cell per
+// element or, with WORM_BODY_RUNS, one run per straight part. Its capacity
+// is a power of two, so an index is wrapped by masking. The buffer doubles
+// when the body grows beyond it.
+// Elements are stored as cell indices of the board (see getCellIndex()),
+// which take half the memory of a struct pos.
+struct worm_body {
+#ifdef WORM_BODY_RUNS
+    struct worm_run* elements; // Ring buffer of runs from the tail to the head
+#else
+    uint32_t* elements;        // Ring buffer of the cells of the worm's elements
+#endif
+    int capacity;   // Number of elements of the buffer (power of two)
+    int mask;       // capacity - 1
+    int headindex;  // Index of the head element (run)
+    int tailindex;  // Index of the tail element (run)
+};
+
+// All worms of a level: the user's worm and worms steered by the computer.
+// The data needed by every step is kept as a structure of arrays with one
+// entry per worm; stepWorms() walks through these arrays from front to back
+// and moves all worms in a single pass.
+// A step of a worm still costs some 0.4 us at -O2 (swarm benchmark, -s):
+// the tail and the head each change a cell, up to five bit planes, the set
+// of free cells and the owner plane, all at scattered places. So 10000
+// worms take milliseconds per tick, not microseconds.
+struct worm_set {
+    int count;       // Number of worms in the set
+    int capacity;    // Maximum number of worms
+    int stride;      // Stride of the board, see getIndexDelta()
+    int max_length;  // Bound for the length: one element per cell of the board
+    bool vector_aim; // Aim the heads with vector instructions (if built in)
+
+    // Hot data, one array per attribute
+    uint32_t* head;        // Cell of the head
+    uint32_t* target;      // Cell the head moves to with the current step
+    int* delta;            // Difference of the cell indices of a step in the current heading
+    uint8_t* heading;      // enum WormHeading
+    uint8_t* state;        // enum GameStates; a worm moves while WORM_GAME_ONGOING
+    int* length;           // Number of elements from the tail to the head
+    int* pending_growth;   // Growth still to come: while it is positive, each
+                           // step keeps the tail in place and the worm gets
+                           // one element longer
+
+    // Cold data
+    struct worm_body* bodies;
+    uint8_t* color;        // enum ColorPairs of the body
+    uint8_t* steered;      // Steered by steerWorms() instead of by the user
+    uint16_t* hit;         // Worm the head ran into (its body or, contending for
+                           // a cell, its head) or WORM_NO_OWNER
+    int* kills;            // Number of other worms that ran into this worm: into
+                           // its body or, contending for a cell, into its head.
+                           // Worms of equal length that perish together do not count.
+
+    uint16_t* owners;
+    // The owner of each cell of the board: the number of the worm using it
+    // or WORM_NO_OWNER. Indexed like the cells (see getCellIndex()) and kept
+    // up to date whenever a head is placed or a tail is cleared. Thus a
+    // collision with a body is told in O(1) without searching the bodies.
+
+    int* changed;          // Cells freed by the last step, see showWorms()
+    int number_changed;    // Number of cells in changed
+    int changed_capacity;  // Size of the array changed
 };
 
-extern enum ResCodes initializeWorm(struct worm* aworm, int len_max, int len_cur,
-                                    struct pos headpos, enum WormHeading dir, enum ColorPairs color);
+extern enum ResCodes initializeWorms(struct worm_set* aset, struct board* aboard, int capacity);
+extern void releaseWorms(struct worm_set* aset);
+extern int addWorm(struct worm_set* aset, struct board* aboard, int len_cur, struct pos headpos,
+                   enum WormHeading dir, enum ColorPairs color, bool steered);
 
-extern void growWorm(struct worm* aworm, enum Boni growth);
-extern void showWorm(struct board* aboard, struct worm* aworm);
-extern void cleanWormTail(struct board* aboard, struct worm* aworm);
-extern void moveWorm(struct board* aboard, struct worm* aworm, enum GameStates* agame_state);
+extern void growWorm(struct worm_set* aset, int worm, enum Boni growth);
+extern void steerWorms(struct worm_set* aset, struct board* aboard, struct rng* arng);
+extern void stepWorms(struct worm_set* aset, struct board* aboard);
+extern void showWorms(struct worm_set* aset, struct board* aboard);
 
 // Getters
-extern struct pos getWormHeadPos(struct worm* aworm);
-extern int getWormLength(struct worm* aworm);
+extern struct pos getWormHeadPos(struct worm_set* aset, struct board* aboard, int worm);
+extern int getWormHeadCell(struct worm_set* aset, int worm);
+extern int getWormLength(struct worm_set* aset, int worm);
+extern enum GameStates getWormState(struct worm_set* aset, int worm);
+extern int getWormHit(struct worm_set* aset, int worm);
+extern int getWormKills(struct worm_set* aset, int worm);
 
 //Setters
-extern void setWormHeading(struct worm* aworm, enum WormHeading dir);
+extern void setWormHeading(struct worm_set* aset, int worm, enum WormHeading dir);
 
 
 #endif  // #define _WORM_MODEL_H